@@ -2,6 +2,8 @@
 #include "string_helpers.hpp"
 
 #include <algorithm>
+#include <cctype>
+#include <fstream>
 #include <iomanip>
 #include <sstream>
 #include <stdexcept>
@@ -10,12 +12,58 @@ using namespace std::literals;
 
 namespace {
 
+// Splits a response file into arguments. Arguments are separated by whitespace and can
+// be wrapped in double quotes to include whitespace. Backslashes are kept as they are so
+// Windows paths need no escaping.
+auto read_response_file(std::istream& response_file) -> std::vector<std::string>
+{
+   std::vector<std::string> args;
+   std::string arg;
+   bool in_arg = false;
+   bool quoted = false;
+
+   for (char c; response_file.get(c);) {
+      if (c == '"') {
+         quoted = !quoted;
+         in_arg = true;
+      }
+      else if (!quoted && std::isspace(static_cast<unsigned char>(c))) {
+         if (in_arg) args.emplace_back(std::move(arg));
+
+         arg.clear();
+         in_arg = false;
+      }
+      else {
+         arg += c;
+         in_arg = true;
+      }
+   }
+
+   if (in_arg) args.emplace_back(std::move(arg));
+
+   return args;
+}
+
 std::stringstream create_arg_stream(int argc, char* argv[])
 {
    std::stringstream arg_stream;
 
    for (auto i = 1; i < argc; ++i) {
-      arg_stream << std::quoted(argv[i]);
+      // "@file" reads further arguments from a response file.
+      if (argv[i][0] == '@') {
+         std::ifstream response_file{argv[i] + 1};
+
+         if (!response_file) {
+            throw std::invalid_argument{"Unable to open response file."};
+         }
+
+         for (const auto& arg : read_response_file(response_file)) {
+            arg_stream << std::quoted(arg);
+         }
+      }
+      else {
+         arg_stream << std::quoted(argv[i]);
+      }
    }
 
    return arg_stream;
@@ -62,6 +110,24 @@ std::istream& operator>>(std::istream& istream, Tool_mode& mode)
    else if (str == "assemble"_sv) {
       mode = Tool_mode::assemble;
    }
+   else if (str == "verify"_sv) {
+      mode = Tool_mode::verify;
+   }
+   else if (str == "diff"_sv) {
+      mode = Tool_mode::diff;
+   }
+   else if (str == "index"_sv) {
+      mode = Tool_mode::index;
+   }
+   else if (str == "query"_sv) {
+      mode = Tool_mode::query;
+   }
+   else if (str == "config"_sv) {
+      mode = Tool_mode::config;
+   }
+   else if (str == "patch"_sv) {
+      mode = Tool_mode::patch;
+   }
    else {
       throw std::invalid_argument{"Invalid tool mode specified."};
    }
@@ -128,17 +194,61 @@ std::istream& operator>>(std::istream& istream, Input_platform& platform)
 
    return istream;
 }
+
+std::istream& operator>>(std::istream& istream, Log_level& level)
+{
+   std::string str;
+   istream >> std::quoted(str);
+
+   if (str == "info"_sv) {
+      level = Log_level::info;
+   }
+   else if (str == "warning"_sv) {
+      level = Log_level::warning;
+   }
+   else if (str == "error"_sv) {
+      level = Log_level::error;
+   }
+   else {
+      throw std::invalid_argument{"Invalid log level specified."};
+   }
+
+   return istream;
+}
+
+std::istream& operator>>(std::istream& istream, Log_format& format)
+{
+   std::string str;
+   istream >> std::quoted(str);
+
+   if (str == "text"_sv) {
+      format = Log_format::text;
+   }
+   else if (str == "json"_sv) {
+      format = Log_format::json;
+   }
+   else {
+      throw std::invalid_argument{"Invalid log format specified."};
+   }
+
+   return istream;
+}
 }
 
 constexpr auto fileinput_opt_description{
-   R"(<filepath> Specify an input file to operate on.)"_sv};
+   R"(<filepath> Specify an input file to operate on. Can be a pattern using '*', '?' and '**'.
+   Example: "-file GameData/**/*.lvl")"_sv};
 
 constexpr auto files_opt_description{
    R"(<files> Specify a list of input files to operate, delimited by ';'.
    Example: "-files foo.lvl;bar.lvl")"_sv};
 
+constexpr auto dir_opt_description{
+   R"(<directory> Operate on every .lvl file in a directory and its subdirectories.)"_sv};
+
 constexpr auto game_ver_opt_description{
-   R"(<version> Set the game version of the input file. Can be 'swbf_ii' or 'swbf. Default is 'swbf_ii'.)"_sv};
+   R"(<version> Set the game version of the input file. Can be 'swbf_ii' or 'swbf. Default is to detect it
+   for each input file, falling back to 'swbf_ii'.)"_sv};
 
 constexpr auto gameout_ver_opt_description{
    R"(<version> Set the game version the output files will target. Can be 'swbf_ii' or 'swbf. Default is 'swbf_ii'.)"_sv};
@@ -147,16 +257,85 @@ constexpr auto image_opt_description{
    R"(<format> Set the output image format for textures. Can be 'tga', 'png' or 'dds'. Default is 'tga'.)"_sv};
 
 constexpr auto input_plat_opt_description{
-   R"(<platform> Set the platform the input file was munged for. Can be 'pc', 'ps2' or 'xbox'. Default is 'pc'.)"_sv};
+   R"(<platform> Set the platform the input file was munged for. Can be 'pc', 'ps2' or 'xbox'. Default is to
+   detect it for each input file, falling back to 'pc'.)"_sv};
 
 constexpr auto verbose_opt_description{
    R"(Enable verbose output.)"_sv};
 
+constexpr auto cache_opt_description{
+   R"(<directory> Keep an extraction cache in a directory. Chunks that have not changed since the
+   last extraction with the same options are skipped. Only used by 'extract'.)"_sv};
+
+constexpr auto journal_opt_description{
+   R"(<directory> Record finished input files in a journal directory. Default is 'swbf-unmunge.journal'
+   when '-resume' is used.)"_sv};
+
+constexpr auto resume_opt_description{
+   R"(Skip input files the journal records as finished by an earlier run in the same mode and
+   with the same output options, provided they have not changed and their output files still exist.)"_sv};
+
+constexpr auto jobs_opt_description{
+   R"(<count> Process the input files with a number of worker processes. Larger files are handed
+   out first and a file that crashes a worker is retried once in a new worker.)"_sv};
+
+constexpr auto worker_opt_description{
+   R"(Used internally by '-jobs'. Read input file paths from standard input, one per line.)"_sv};
+
+constexpr auto loglevel_opt_description{
+   R"(<level> Set the least severe messages to print. Can be 'info', 'warning' or 'error'. Default is 'info'.)"_sv};
+
+constexpr auto logfmt_opt_description{
+   R"(<format> Set the format of printed messages. Can be 'text' or 'json'. Default is 'text'.
+   'json' prints one object per line with a "level" and a "message" field.
+   The results of the 'config', 'diff' and 'query' modes are printed as plain text whatever the format.)"_sv};
+
+constexpr auto errorreport_opt_description{
+   R"(<file> Save every error that occured to a JSON file, with the input file, chunk path, offset,
+   magic number and handler of each.)"_sv};
+
+constexpr auto maxerrors_opt_description{
+   R"(<count> Exit with a failure status if more than this many errors occur. Default is 0.)"_sv};
+
+constexpr auto index_opt_description{
+   R"(<file> Set the index file used by the 'index' and 'query' modes. Default is 'swbf-unmunge.index'.)"_sv};
+
+constexpr auto query_opt_description{
+   R"(<name> Find the chunks with a name, or with a content hash given as 16 hex digits, in the index.
+   Can be used more than once.)"_sv};
+
+constexpr auto queryextract_opt_description{
+   R"(Extract each chunk found by '-query' from its file, into the directory 'extract' would use.)"_sv};
+
+constexpr auto configquery_opt_description{
+   R"(<path> Find the values at a path of config keys, such as 'SkyInfo.FogRange', in the 'config' mode.
+   '*' matches any key. Can be used more than once.)"_sv};
+
+constexpr auto patchchunk_opt_description{
+   R"(<path> Set the chunk replaced by the 'patch' mode, as the magic numbers leading to it from the root
+   chunk separated by '/'. Each can be followed by ':' and a name to pick the chunk or level with that name,
+   such as 'ucfb/lvl_:cor1/tex_:cor_floor'.)"_sv};
+
+constexpr auto patchfile_opt_description{
+   R"(<file> Set the file holding the new contents of the chunk replaced by the 'patch' mode.)"_sv};
+
 constexpr auto mode_opt_description{
-   R"(<mode> Set the mode of operation for the tool. Can be 'extract', 'explode' or 'assemble'.
+   R"(<mode> Set the mode of operation for the tool. Can be 'extract', 'explode', 'assemble', 'verify', 'diff',
+   'index', 'query', 'config' or 'patch'.
    'extract' (default) - Extract and "unmunge" the contents of the file.
-   'explode' - Recursively explode the file's chunks into their hierarchies.
-   'assemble' - Recursively assemble a previously exploded file. Input files will be treated as directories.)"_sv};
+   'explode' - Recursively explode the file's chunks into a manifest of their hierarchy and a file for the
+   contents of each chunk that holds data.
+   'assemble' - Recursively assemble a previously exploded file. Input files will be treated as directories.
+   'verify' - Decode the file as 'extract' would but discard the output, reporting any errors and saving a
+   manifest of chunk and output checksums next to the file.
+   'diff' - Compare the chunks of two files, given as the old file followed by the new file, and report
+   which were added, removed or changed.
+   'index' - Scan the names, offsets and content hashes of the chunks in the files into an index file.
+   'query' - Look up the chunks named by '-query' in an index file.
+   'config' - Answer the '-configquery' queries from the config chunks of the files without writing any
+   files.
+   'patch' - Replace the contents of the chunk at '-patchchunk' in each file with those of '-patchfile'.
+   The files are changed in place.)"_sv};
 
 App_options::App_options()
 {
@@ -167,16 +346,54 @@ App_options::App_options()
        fileinput_opt_description},
       {"-files"s, [this](Istr& istr) { append_file_list(istr, _input_files); },
        files_opt_description},
-      {"-version"s, [this](Istr& istr) { istr >> _game_version; },
+      {"-dir"s,
+       [this](Istr& istr) {
+          _input_files.emplace_back(read_file_path(istr) + "/**/*.lvl"s);
+       },
+       dir_opt_description},
+      {"-version"s, [this](Istr& istr) { istr >> _game_version.emplace(); },
        game_ver_opt_description},
       {"-outversion"s, [this](Istr& istr) { istr >> _output_game_version; },
        gameout_ver_opt_description},
       {"-imgfmt"s, [this](Istr& istr) { istr >> _img_save_format; },
        image_opt_description},
-      {"-platform"s, [this](Istr& istr) { istr >> _input_platform; },
+      {"-platform"s, [this](Istr& istr) { istr >> _input_platform.emplace(); },
        input_plat_opt_description},
       {"-verbose"s, [this](Istr&) { _verbose = true; }, verbose_opt_description},
-      {"-mode"s, [this](Istr& istr) { istr >> _tool_mode; }, mode_opt_description}};
+      {"-mode"s, [this](Istr& istr) { istr >> _tool_mode; }, mode_opt_description},
+      {"-cache"s, [this](Istr& istr) { _cache_directory = read_file_path(istr); },
+       cache_opt_description},
+      {"-journal"s, [this](Istr& istr) { _journal_directory = read_file_path(istr); },
+       journal_opt_description},
+      {"-resume"s,
+       [this](Istr&) {
+          _resume = true;
+
+          if (_journal_directory.empty()) _journal_directory = "swbf-unmunge.journal"s;
+       },
+       resume_opt_description},
+      {"-jobs"s, [this](Istr& istr) { istr >> _jobs; }, jobs_opt_description},
+      {"-worker"s, [this](Istr&) { _worker = true; }, worker_opt_description},
+      {"-loglevel"s, [this](Istr& istr) { istr >> _log_level; },
+       loglevel_opt_description},
+      {"-logfmt"s, [this](Istr& istr) { istr >> _log_format; }, logfmt_opt_description},
+      {"-errorreport"s, [this](Istr& istr) { _error_report_file = read_file_path(istr); },
+       errorreport_opt_description},
+      {"-maxerrors"s, [this](Istr& istr) { istr >> _max_errors; },
+       maxerrors_opt_description},
+      {"-index"s, [this](Istr& istr) { _index_file = read_file_path(istr); },
+       index_opt_description},
+      {"-query"s, [this](Istr& istr) { _queries.emplace_back(read_file_path(istr)); },
+       query_opt_description},
+      {"-queryextract"s, [this](Istr&) { _query_extract = true; },
+       queryextract_opt_description},
+      {"-configquery"s,
+       [this](Istr& istr) { _config_queries.emplace_back(read_file_path(istr)); },
+       configquery_opt_description},
+      {"-patchchunk"s, [this](Istr& istr) { _patch_chunk = read_file_path(istr); },
+       patchchunk_opt_description},
+      {"-patchfile"s, [this](Istr& istr) { _patch_file = read_file_path(istr); },
+       patchfile_opt_description}};
 }
 
 App_options::App_options(int argc, char* argv[]) : App_options()
@@ -204,7 +421,7 @@ Tool_mode App_options::tool_mode() const noexcept
    return _tool_mode;
 }
 
-Game_version App_options::game_version() const noexcept
+auto App_options::game_version_override() const noexcept -> std::optional<Game_version>
 {
    return _game_version;
 }
@@ -219,7 +436,7 @@ Image_format App_options::image_save_format() const noexcept
    return _img_save_format;
 }
 
-Input_platform App_options::input_platform() const noexcept
+auto App_options::platform_override() const noexcept -> std::optional<Input_platform>
 {
    return _input_platform;
 }
@@ -229,6 +446,81 @@ bool App_options::verbose() const noexcept
    return _verbose;
 }
 
+auto App_options::cache_directory() const noexcept -> const std::string&
+{
+   return _cache_directory;
+}
+
+auto App_options::journal_directory() const noexcept -> const std::string&
+{
+   return _journal_directory;
+}
+
+bool App_options::resume() const noexcept
+{
+   return _resume;
+}
+
+unsigned App_options::jobs() const noexcept
+{
+   return _jobs;
+}
+
+bool App_options::worker() const noexcept
+{
+   return _worker;
+}
+
+Log_level App_options::log_level() const noexcept
+{
+   return _log_level;
+}
+
+Log_format App_options::log_format() const noexcept
+{
+   return _log_format;
+}
+
+auto App_options::error_report_file() const noexcept -> const std::string&
+{
+   return _error_report_file;
+}
+
+std::size_t App_options::max_errors() const noexcept
+{
+   return _max_errors;
+}
+
+auto App_options::index_file() const noexcept -> const std::string&
+{
+   return _index_file;
+}
+
+auto App_options::queries() const noexcept -> const std::vector<std::string>&
+{
+   return _queries;
+}
+
+bool App_options::query_extract() const noexcept
+{
+   return _query_extract;
+}
+
+auto App_options::config_queries() const noexcept -> const std::vector<std::string>&
+{
+   return _config_queries;
+}
+
+auto App_options::patch_chunk() const noexcept -> const std::string&
+{
+   return _patch_chunk;
+}
+
+auto App_options::patch_file() const noexcept -> const std::string&
+{
+   return _patch_file;
+}
+
 void App_options::print_arguments(std::ostream& ostream) noexcept
 {
    ostream << '\n';
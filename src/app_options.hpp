@@ -1,11 +1,25 @@
 #pragma once
 
+#include "logger.hpp"
+
+#include <cstddef>
 #include <functional>
 #include <iosfwd>
+#include <optional>
 #include <string>
 #include <vector>
 
-enum class Tool_mode { extract, explode, assemble };
+enum class Tool_mode {
+   extract,
+   explode,
+   assemble,
+   verify,
+   diff,
+   index,
+   query,
+   config,
+   patch
+};
 
 enum class Image_format { tga, png, dds };
 
@@ -13,6 +27,11 @@ enum class Game_version { swbf_ii, swbf };
 
 enum class Input_platform { pc, ps2, xbox };
 
+struct Input_format {
+   Input_platform platform = Input_platform::pc;
+   Game_version game_version = Game_version::swbf_ii;
+};
+
 class App_options {
 public:
    App_options(const App_options&) = delete;
@@ -26,16 +45,46 @@ public:
 
    Tool_mode tool_mode() const noexcept;
 
-   Game_version game_version() const noexcept;
+   auto game_version_override() const noexcept -> std::optional<Game_version>;
 
    Game_version output_game_version() const noexcept;
 
    Image_format image_save_format() const noexcept;
 
-   Input_platform input_platform() const noexcept;
+   auto platform_override() const noexcept -> std::optional<Input_platform>;
 
    bool verbose() const noexcept;
 
+   auto cache_directory() const noexcept -> const std::string&;
+
+   auto journal_directory() const noexcept -> const std::string&;
+
+   bool resume() const noexcept;
+
+   unsigned jobs() const noexcept;
+
+   bool worker() const noexcept;
+
+   Log_level log_level() const noexcept;
+
+   Log_format log_format() const noexcept;
+
+   auto error_report_file() const noexcept -> const std::string&;
+
+   std::size_t max_errors() const noexcept;
+
+   auto index_file() const noexcept -> const std::string&;
+
+   auto queries() const noexcept -> const std::vector<std::string>&;
+
+   bool query_extract() const noexcept;
+
+   auto config_queries() const noexcept -> const std::vector<std::string>&;
+
+   auto patch_chunk() const noexcept -> const std::string&;
+
+   auto patch_file() const noexcept -> const std::string&;
+
    void print_arguments(std::ostream& ostream) noexcept;
 
 private:
@@ -55,9 +104,24 @@ private:
 
    std::vector<std::string> _input_files;
    Tool_mode _tool_mode = Tool_mode::extract;
-   Game_version _game_version = Game_version::swbf_ii;
+   std::optional<Game_version> _game_version;
    Game_version _output_game_version = Game_version::swbf_ii;
    Image_format _img_save_format = Image_format::tga;
-   Input_platform _input_platform = Input_platform::pc;
+   std::optional<Input_platform> _input_platform;
    bool _verbose = false;
+   std::string _cache_directory;
+   std::string _journal_directory;
+   bool _resume = false;
+   unsigned _jobs = 1;
+   bool _worker = false;
+   Log_level _log_level = Log_level::info;
+   Log_format _log_format = Log_format::text;
+   std::string _error_report_file;
+   std::size_t _max_errors = 0;
+   std::string _index_file = "swbf-unmunge.index";
+   std::vector<std::string> _queries;
+   bool _query_extract = false;
+   std::vector<std::string> _config_queries;
+   std::string _patch_chunk;
+   std::string _patch_file;
 };
\ No newline at end of file
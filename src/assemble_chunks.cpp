@@ -1,4 +1,6 @@
 
+#include "assemble_chunks.hpp"
+#include "explode_chunk.hpp"
 #include "file_saver.hpp"
 #include "string_helpers.hpp"
 #include "ucfb_builder.hpp"
@@ -6,7 +8,10 @@
 #include "tbb/concurrent_vector.h"
 #include "tbb/task_group.h"
 
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -21,20 +26,30 @@ struct Directory_info {
    Magic_number magic_number;
 };
 
+struct Manifest_entry {
+   std::size_t depth;
+   Magic_number magic_number;
+   bool parent;
+   std::size_t child_count = 0;
+   std::string file;
+};
+
+Magic_number parse_magic_number(std::string_view string)
+{
+   if (string.length() == 4) {
+      return create_magic_number(string[0], string[1], string[2], string[3]);
+   }
+
+   return deserialize_magic_number(string);
+}
+
 Directory_info decompose_name(std::string_view string)
 {
    const auto components = split_string(string, ' ');
 
    Directory_info info;
    info.index = std::stoull(std::string{components[0]});
-
-   if (components[1].length() == 4) {
-      info.magic_number = create_magic_number(components[1][0], components[1][1],
-                                              components[1][2], components[1][3]);
-   }
-   else {
-      info.magic_number = deserialize_magic_number(components[1]);
-   }
+   info.magic_number = parse_magic_number(components[1]);
 
    return info;
 }
@@ -99,6 +114,142 @@ Ucfb_builder assemble_directory(const fs::path& directory)
 
    return builder;
 }
+
+auto get_manifest_path(const fs::path& directory) -> fs::path
+{
+   std::string name{explode_manifest_name};
+   name += explode_manifest_extension;
+
+   return directory / fs::u8path(name);
+}
+
+// Counts the children of each parent, so their builders can reserve space for them.
+void count_children(std::vector<Manifest_entry>& entries) noexcept
+{
+   std::vector<std::size_t> parents;
+
+   for (std::size_t i = 0; i < entries.size(); ++i) {
+      const auto depth = entries[i].depth;
+
+      if (depth > parents.size()) continue;
+
+      parents.resize(depth);
+
+      if (!parents.empty()) ++entries[parents.back()].child_count;
+
+      if (entries[i].parent) parents.push_back(i);
+   }
+}
+
+auto read_manifest(const fs::path& path) -> std::vector<Manifest_entry>
+{
+   std::ifstream file{path, std::ios::binary};
+
+   std::string line;
+
+   if (!std::getline(file, line) || line != explode_manifest_header) {
+      throw std::runtime_error{"Unsupported explode manifest: "s += path.u8string()};
+   }
+
+   std::vector<Manifest_entry> entries;
+   entries.reserve(1024);
+
+   while (std::getline(file, line)) {
+      if (line.empty()) continue;
+
+      std::istringstream stream{line};
+
+      std::string kind;
+      std::string magic_number;
+      std::size_t offset{};
+      std::size_t size{};
+
+      auto& entry = entries.emplace_back();
+
+      // The offset and size are only there for people reading the manifest.
+      stream >> kind >> entry.depth >> magic_number >> offset >> size;
+
+      entry.magic_number = parse_magic_number(magic_number);
+      entry.parent = (kind == "parent"_sv);
+
+      if (!entry.parent) stream >> entry.file;
+
+      if (!stream || (kind != "parent"_sv && kind != "data"_sv)) {
+         throw std::runtime_error{"Bad explode manifest entry: "s += line};
+      }
+   }
+
+   if (entries.empty()) {
+      throw std::runtime_error{"Empty explode manifest: "s += path.u8string()};
+   }
+
+   count_children(entries);
+
+   return entries;
+}
+
+// The assembled file is written out as the tree is walked, it is never held in memory
+// whole.
+void save_assembled(const Ucfb_builder& root, const fs::path& directory,
+                    File_saver& file_saver)
+{
+   file_saver.save_file_blocks(""_sv, directory.stem().u8string(), ".assembled"_sv,
+                               [&root](const File_saver::Block_sink& sink) {
+                                  root.write_blocks(sink);
+                               });
+}
+
+// Rebuilds the chunk tree from the manifest's depth first list of chunks. Data chunks
+// only reference their files, which are not opened until the tree is written out.
+Ucfb_builder assemble_manifest(const fs::path& directory)
+{
+   const auto entries = read_manifest(get_manifest_path(directory));
+
+   // Data files are listed relative to the exploded directory. Their size is taken from
+   // the file, the size in the manifest is from when the file was exploded and data
+   // files are free to be edited since.
+   const auto create_data_chunk = [&directory](const Manifest_entry& entry) {
+      return Ucfb_builder{directory / fs::u8path(entry.file), entry.magic_number};
+   };
+
+   if (!entries.front().parent) {
+      if (entries.size() != 1) {
+         throw std::runtime_error{"Bad chunk depth in explode manifest."};
+      }
+
+      return create_data_chunk(entries.front());
+   }
+
+   std::vector<Ucfb_builder> open_parents;
+
+   const auto close_parent = [&open_parents] {
+      auto child = std::move(open_parents.back());
+      open_parents.pop_back();
+
+      open_parents.back().add_child(std::move(child));
+   };
+
+   for (std::size_t i = 0; i < entries.size(); ++i) {
+      const auto& entry = entries[i];
+
+      if ((entry.depth == 0) != (i == 0) || entry.depth > open_parents.size()) {
+         throw std::runtime_error{"Bad chunk depth in explode manifest."};
+      }
+
+      while (open_parents.size() > entry.depth) close_parent();
+
+      if (entry.parent) {
+         open_parents.emplace_back(entry.magic_number).reserve_children(entry.child_count);
+      }
+      else {
+         open_parents.back().add_child(create_data_chunk(entry));
+      }
+   }
+
+   while (open_parents.size() > 1) close_parent();
+
+   return std::move(open_parents.back());
+}
 }
 
 void assemble_chunks(fs::path directory, File_saver& file_saver)
@@ -107,15 +258,20 @@ void assemble_chunks(fs::path directory, File_saver& file_saver)
       throw std::invalid_argument{"Directory does not exist."};
    }
 
+   if (fs::is_regular_file(get_manifest_path(directory))) {
+      save_assembled(assemble_manifest(directory), directory, file_saver);
+
+      return;
+   }
+
+   // Directories exploded before explode wrote manifests hold a directory per parent
+   // chunk, named after its index and magic number.
    const auto entry = fs::directory_iterator{directory};
 
    const auto& path = entry->path();
 
    if (fs::is_directory(path)) {
-      const auto root = assemble_directory(path);
-
-      file_saver.save_file(root.create_buffer(), "", directory.stem().u8string(),
-                           ".assembled"_sv);
+      save_assembled(assemble_directory(path), directory, file_saver);
    }
    else {
       throw std::runtime_error{"Unexpected entry in directory: "s += path.u8string()};
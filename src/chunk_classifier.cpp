@@ -0,0 +1,84 @@
+#include "chunk_classifier.hpp"
+
+#include <array>
+
+namespace {
+
+// How many scans of a magic number must find only data before it is treated as data.
+constexpr std::uint32_t leaf_threshold = 4;
+
+constexpr std::array<Magic_number, 25> known_leaves{
+   "NAME"_mn, "DATA"_mn, "BODY"_mn, "INFO"_mn, "STR_"_mn, "TYPE"_mn, "SIZE"_mn,
+   "PROP"_mn, "BASE"_mn, "VBUF"_mn, "IBUF"_mn, "MTRL"_mn, "RTYP"_mn, "TNAM"_mn,
+   "BBOX"_mn, "XFRM"_mn, "POSI"_mn, "TRAN"_mn, "BNAM"_mn, "PRNT"_mn, "MINA"_mn,
+   "TNJA"_mn, "TADA"_mn, "HASH"_mn, "VRTX"_mn};
+
+constexpr std::array<Magic_number, 21> known_parents{
+   "ucfb"_mn, "tex_"_mn, "FMT_"_mn, "FACE"_mn, "LVL_"_mn, "modl"_mn, "segm"_mn,
+   "skel"_mn, "coll"_mn, "gmod"_mn, "entc"_mn, "ordc"_mn, "wpnc"_mn, "expc"_mn,
+   "fx__"_mn, "sky_"_mn, "SCOP"_mn, "Locl"_mn, "wrld"_mn, "inst"_mn, "scr_"_mn};
+}
+
+Chunk_classifier::Chunk_classifier()
+{
+   _entries.reserve(256);
+
+   for (const auto magic_number : known_leaves) {
+      _entries[magic_number].kind = Kind::known_leaf;
+   }
+
+   for (const auto magic_number : known_parents) {
+      _entries[magic_number].kind = Kind::known_parent;
+   }
+}
+
+bool Chunk_classifier::should_scan(const Magic_number magic_number,
+                                   const std::size_t size) noexcept
+{
+   bool scan = true;
+
+   {
+      tbb::spin_rw_mutex::scoped_lock lock{_entries_mutex, false};
+
+      if (const auto entry = _entries.find(magic_number); entry != _entries.cend()) {
+         const auto kind = entry->second.kind;
+
+         scan = kind != Kind::known_leaf && kind != Kind::leaf;
+      }
+   }
+
+   if (scan) {
+      ++_scanned_chunks;
+   }
+   else {
+      ++_skipped_chunks;
+      _skipped_bytes += size;
+   }
+
+   return scan;
+}
+
+void Chunk_classifier::record_scan(const Magic_number magic_number,
+                                   const std::size_t size, const bool had_children)
+{
+   if (!had_children) _wasted_bytes += size;
+
+   tbb::spin_rw_mutex::scoped_lock lock{_entries_mutex, true};
+
+   auto& entry = _entries[magic_number];
+
+   if (entry.kind != Kind::learning) return;
+
+   if (had_children) {
+      entry.kind = Kind::parent;
+   }
+   else if (++entry.leaf_scans >= leaf_threshold) {
+      entry.kind = Kind::leaf;
+   }
+}
+
+auto Chunk_classifier::stats() const noexcept -> Stats
+{
+   return {_scanned_chunks.load(), _skipped_chunks.load(), _skipped_bytes.load(),
+           _wasted_bytes.load()};
+}
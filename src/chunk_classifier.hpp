@@ -0,0 +1,66 @@
+#pragma once
+
+#include "magic_number.hpp"
+
+#include "tbb/spin_rw_mutex.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+//! \brief Threadsafe record of which magic numbers belong to chunks holding children.
+//!
+//! Chunks of a magic number known to only ever hold data are not scanned for children.
+//! Magic numbers missing from the built in table are learned during a run, a magic number
+//! whose chunks have been scanned a few times and never held children is treated as data
+//! from then on. A magic number that has held children once is always scanned.
+//!
+//! As what is learned depends on the order chunks are seen in, which chunks of a rarely
+//! used magic number are exploded can differ between runs. The bytes of every chunk are
+//! kept either way.
+class Chunk_classifier {
+public:
+   struct Stats {
+      std::uint64_t scanned_chunks;
+      std::uint64_t skipped_chunks;
+
+      //! Bytes of chunks that were not scanned for children.
+      std::uint64_t skipped_bytes;
+
+      //! Bytes of chunks that were scanned for children and turned out to hold data.
+      std::uint64_t wasted_bytes;
+   };
+
+   Chunk_classifier();
+
+   Chunk_classifier(const Chunk_classifier&) = delete;
+   Chunk_classifier& operator=(const Chunk_classifier&) = delete;
+   Chunk_classifier(Chunk_classifier&&) = delete;
+   Chunk_classifier& operator=(Chunk_classifier&&) = delete;
+
+   //! \brief Checks if a chunk might hold children and so should be scanned for them.
+   bool should_scan(const Magic_number magic_number, const std::size_t size) noexcept;
+
+   //! \brief Records the result of scanning a chunk for children.
+   void record_scan(const Magic_number magic_number, const std::size_t size,
+                    const bool had_children);
+
+   auto stats() const noexcept -> Stats;
+
+private:
+   enum class Kind : std::uint8_t { known_leaf, known_parent, learning, leaf, parent };
+
+   struct Entry {
+      Kind kind = Kind::learning;
+      std::uint32_t leaf_scans = 0;
+   };
+
+   std::unordered_map<Magic_number, Entry> _entries;
+   mutable tbb::spin_rw_mutex _entries_mutex;
+
+   std::atomic<std::uint64_t> _scanned_chunks{0};
+   std::atomic<std::uint64_t> _skipped_chunks{0};
+   std::atomic<std::uint64_t> _skipped_bytes{0};
+   std::atomic<std::uint64_t> _wasted_bytes{0};
+};
@@ -0,0 +1,173 @@
+#include "chunk_diff.hpp"
+#include "content_hash.hpp"
+#include "string_helpers.hpp"
+#include "swbf_fnv_hashes.hpp"
+
+#include "tbb/parallel_for_each.h"
+#include "tbb/parallel_invoke.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <new>
+#include <tuple>
+
+using namespace std::literals;
+
+namespace {
+
+struct Child {
+   Magic_number magic_number;
+   std::string name;
+   std::size_t ordinal = 0;
+   Ucfb_reader reader;
+   std::uint64_t hash = 0;
+};
+
+using Child_key = std::tuple<Magic_number, std::string_view, std::size_t>;
+
+auto child_key(const Child& child) -> Child_key
+{
+   return {child.magic_number, child.name, child.ordinal};
+}
+
+auto child_name(Ucfb_reader chunk) -> std::string
+{
+   if (chunk.magic_number() == "lvl_"_mn) {
+      const auto name_hash = chunk.read_trivial<std::uint32_t>();
+
+      if (const auto name = find_fnv_hash(name_hash); name) return std::string{*name};
+
+      return to_hexstring(name_hash);
+   }
+
+   // Most asset chunks start with a NAME child, any other chunk is only matched by its
+   // magic number and position.
+   const auto first_child = chunk.read_child(std::nothrow);
+
+   if (!first_child || first_child->magic_number() != "NAME"_mn) return ""s;
+
+   auto name = *first_child;
+
+   return std::string{name.read_string()};
+}
+
+auto read_children(Ucfb_reader parent) -> std::vector<Child>
+{
+   if (parent.magic_number() == "lvl_"_mn) {
+      parent.consume(4); // lvl name hash
+      parent.consume(4); // lvl size left
+   }
+
+   std::vector<Child> children;
+
+   while (parent) {
+      const auto child = parent.read_child();
+
+      children.push_back({child.magic_number(), child_name(child), 0, child});
+   }
+
+   // Chunks with the same magic number and name are matched in the order they appear.
+   std::map<std::pair<Magic_number, std::string_view>, std::size_t> counts;
+
+   for (auto& child : children) {
+      child.ordinal = counts[{child.magic_number, child.name}]++;
+   }
+
+   tbb::parallel_for_each(children, [](Child& child) {
+      child.hash = content_hash(child.reader.bytes(),
+                                static_cast<std::uint32_t>(child.magic_number));
+   });
+
+   return children;
+}
+
+auto child_path(const std::string& parent_path, const Child& child) -> std::string
+{
+   auto path = parent_path;
+   path += '/';
+   path += view_pod_as_string(child.magic_number);
+
+   return path;
+}
+
+void diff_children(Ucfb_reader old_parent, Ucfb_reader new_parent,
+                   const std::string& parent_path, std::vector<Chunk_change>& changes)
+{
+   std::vector<Child> old_children;
+   std::vector<Child> new_children;
+
+   tbb::parallel_invoke([&] { old_children = read_children(old_parent); },
+                        [&] { new_children = read_children(new_parent); });
+
+   std::map<Child_key, const Child*> old_lookup;
+
+   for (const auto& child : old_children) old_lookup[child_key(child)] = &child;
+
+   for (const auto& new_child : new_children) {
+      const auto old_entry = old_lookup.find(child_key(new_child));
+      const auto path = child_path(parent_path, new_child);
+
+      if (old_entry == std::end(old_lookup)) {
+         changes.push_back({Chunk_change_kind::added, path, new_child.name, 0,
+                            new_child.reader.size()});
+
+         continue;
+      }
+
+      const auto& old_child = *old_entry->second;
+
+      old_lookup.erase(old_entry);
+
+      if (old_child.hash == new_child.hash &&
+          old_child.reader.size() == new_child.reader.size()) {
+         continue;
+      }
+
+      const auto changes_before = changes.size();
+
+      if (new_child.magic_number == "lvl_"_mn) {
+         diff_children(old_child.reader, new_child.reader, path, changes);
+      }
+
+      // A lvl_ whose children all match differs in its header or padding, so it is
+      // reported as changed itself.
+      if (changes.size() == changes_before) {
+         changes.push_back({Chunk_change_kind::changed, path, new_child.name,
+                            old_child.reader.size(), new_child.reader.size()});
+      }
+   }
+
+   for (const auto& old_child : old_children) {
+      if (old_lookup.count(child_key(old_child)) == 0) continue;
+
+      changes.push_back({Chunk_change_kind::removed, child_path(parent_path, old_child),
+                         old_child.name, old_child.reader.size(), 0});
+   }
+}
+}
+
+auto diff_chunks(Ucfb_reader old_root, Ucfb_reader new_root) -> std::vector<Chunk_change>
+{
+   std::vector<Chunk_change> changes;
+
+   diff_children(old_root, new_root,
+                 std::string{view_pod_as_string(new_root.magic_number())}, changes);
+
+   return changes;
+}
+
+auto to_string(const Chunk_change_kind kind) -> std::string_view
+{
+   switch (kind) {
+   case Chunk_change_kind::added:
+      return "added"_sv;
+   case Chunk_change_kind::removed:
+      return "removed"_sv;
+   case Chunk_change_kind::changed:
+      return "changed"_sv;
+   }
+
+   return ""_sv;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ucfb_reader.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class Chunk_change_kind { added, removed, changed };
+
+struct Chunk_change {
+   Chunk_change_kind kind;
+   std::string path;
+   std::string name;
+   std::size_t old_size = 0;
+   std::size_t new_size = 0;
+};
+
+//! \brief Finds the top level chunks that differ between two ucfb files.
+//!
+//! Children are matched by magic number and name, the contents of their NAME child or
+//! the name hash of an lvl_ chunk. Matched chunks are compared by a hash of their
+//! contents and the children of changed lvl_ chunks are compared in turn. No handler
+//! runs, so this takes time proportional to the size of the files.
+//!
+//! \param old_root The root chunk of the old file.
+//! \param new_root The root chunk of the new file.
+//!
+//! \return The added, removed and changed chunks, in the order they appear in the files.
+//!
+//! \exception std::runtime_error Thrown when a chunk's size runs past its parent.
+auto diff_chunks(Ucfb_reader old_root, Ucfb_reader new_root) -> std::vector<Chunk_change>;
+
+auto to_string(const Chunk_change_kind kind) -> std::string_view;
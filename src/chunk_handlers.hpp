@@ -7,6 +7,7 @@
 #include <optional>
 #include <string>
 
+class Extract_cache;
 class File_saver;
 
 void handle_unknown(Ucfb_reader chunk, File_saver& file_saver,
@@ -14,10 +15,11 @@ void handle_unknown(Ucfb_reader chunk, File_saver& file_saver,
                     std::optional<std::string_view> file_extension = {});
 
 void handle_ucfb(Ucfb_reader chunk, const App_options& app_options,
-                 File_saver& file_saver);
+                 const Input_format input_format, File_saver& file_saver,
+                 Extract_cache* cache = nullptr);
 
 void handle_lvl_child(Ucfb_reader lvl_child, const App_options& app_options,
-                      File_saver& file_saver);
+                      const Input_format input_format, File_saver& file_saver);
 
 void handle_object(Ucfb_reader object, File_saver& file_saver, std::string_view type);
 
@@ -70,3 +72,7 @@ void handle_binary(Ucfb_reader binary, File_saver& file_saver,
                    std::string_view extension);
 
 void handle_zaabin(Ucfb_reader zaabin, File_saver& file_saver);
+
+void handle_zafbin(Ucfb_reader zafbin, File_saver& file_saver);
+
+void handle_sound_bank(Ucfb_reader bank, File_saver& file_saver);
@@ -0,0 +1,357 @@
+#include "chunk_index.hpp"
+#include "content_hash.hpp"
+#include "error_report.hpp"
+#include "file_saver.hpp"
+#include "input_discovery.hpp"
+#include "logger.hpp"
+#include "string_helpers.hpp"
+#include "swbf_fnv_hashes.hpp"
+#include "type_pun.hpp"
+#include "ucfb_reader.hpp"
+
+#include "tbb/concurrent_vector.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+namespace fs = std::filesystem;
+using namespace std::literals;
+
+namespace {
+
+constexpr std::array<char, 8> index_magic{'s', 'w', 'b', 'f', 'i', 'd', 'x', '\0'};
+constexpr std::uint32_t index_version = 1;
+
+// Followed by the entries, the content hash order, the file table and the strings.
+struct Index_header {
+   std::array<char, 8> magic;
+   std::uint32_t version;
+   std::uint32_t file_count;
+   std::uint32_t entry_count;
+   std::uint32_t strings_size;
+};
+
+static_assert(sizeof(Index_header) == 24);
+
+struct Scanned_chunk {
+   std::string name;
+   std::uint32_t name_hash;
+   Magic_number magic_number;
+   std::uint32_t offset;
+   std::uint32_t size;
+   std::uint32_t parent_offset;
+   std::uint64_t content_hash;
+};
+
+struct Scanned_file {
+   std::string path;
+   std::vector<Scanned_chunk> chunks;
+};
+}
+
+auto chunk_names(Ucfb_reader chunk) -> std::vector<std::string>
+{
+   const auto first_child = chunk.read_child(std::nothrow);
+
+   if (!first_child) return {};
+
+   auto first = *first_child;
+
+   if (first.magic_number() == "NAME"_mn) return {std::string{first.read_string()}};
+
+   // Object classes have their base class in BASE, followed by their own in TYPE.
+   if (first.magic_number() == "BASE"_mn) {
+      const auto base = first.read_string();
+      const auto second_child = chunk.read_child(std::nothrow);
+
+      if (!second_child || second_child->magic_number() != "TYPE"_mn) {
+         return {std::string{base}};
+      }
+
+      auto type = *second_child;
+
+      return {std::string{type.read_string()}, std::string{base}};
+   }
+
+   return {};
+}
+
+namespace {
+
+void scan_children(Ucfb_reader parent, const std::uint32_t parent_offset,
+                   const std::byte* const file_begin, std::vector<Scanned_chunk>& chunks)
+{
+   if (parent.magic_number() == "lvl_"_mn) {
+      parent.consume(4); // lvl name hash
+      parent.consume(4); // lvl size left
+   }
+
+   while (parent) {
+      const auto child = parent.read_child();
+
+      const auto offset =
+         static_cast<std::uint32_t>(child.bytes().data() - file_begin) - 8;
+      const auto size = static_cast<std::uint32_t>(child.size());
+      const auto hash = content_hash(child.bytes(),
+                                     static_cast<std::uint32_t>(child.magic_number()));
+
+      const auto add = [&](std::string name, const std::uint32_t name_hash) {
+         chunks.push_back({std::move(name), name_hash, child.magic_number(), offset, size,
+                           parent_offset, hash});
+      };
+
+      if (child.magic_number() == "lvl_"_mn) {
+         auto lvl = child;
+         const auto name_hash = lvl.read_trivial<std::uint32_t>();
+
+         const auto name = find_fnv_hash(name_hash);
+
+         add(name ? std::string{*name} : to_hexstring(name_hash), name_hash);
+         scan_children(child, offset, file_begin, chunks);
+
+         continue;
+      }
+
+      // A name that can not be read still leaves the chunk findable by its contents.
+      std::vector<std::string> names;
+
+      try {
+         names = chunk_names(child);
+      }
+      catch (const std::exception&) {
+      }
+
+      if (names.empty()) names.emplace_back();
+
+      for (auto& name : names) {
+         const auto name_hash = fnv_1a_hash(name);
+
+         add(std::move(name), name_hash);
+      }
+   }
+}
+
+auto scan_file(const std::string& input) -> Scanned_file
+{
+   Mapped_file file{fs::u8path(input)};
+   Ucfb_reader root{file.bytes()};
+
+   if (root.magic_number() != "ucfb"_mn) {
+      throw std::runtime_error{"Root chunk is not ucfb as expected."};
+   }
+
+   Scanned_file scanned{fs::absolute(fs::u8path(input)).u8string()};
+
+   scan_children(root, 0, root.bytes().data() - 8, scanned.chunks);
+
+   return scanned;
+}
+
+bool equals_ignoring_case(std::string_view left, std::string_view right) noexcept
+{
+   return std::equal(std::cbegin(left), std::cend(left), std::cbegin(right),
+                     std::cend(right), [](const char l, const char r) {
+                        return std::tolower(static_cast<unsigned char>(l)) ==
+                               std::tolower(static_cast<unsigned char>(r));
+                     });
+}
+
+bool is_hash_string(std::string_view string) noexcept
+{
+   return string.size() == 16 &&
+          std::all_of(std::cbegin(string), std::cend(string), [](const char c) {
+             return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+          });
+}
+}
+
+void build_chunk_index(const std::vector<std::string>& inputs, const fs::path& index_file)
+{
+   tbb::concurrent_vector<Scanned_file> scanned_files;
+
+   for_each_input(inputs, false, [&](const std::string& input) {
+      try {
+         scanned_files.push_back(scan_file(input));
+      }
+      catch (std::exception& e) {
+         error_report::add_error(input, ""s, "build_chunk_index"_sv, e.what());
+
+         logger::error("Exception occured while indexing file.\n   File: "s, input,
+                       "\n   Message: "s, e.what());
+      }
+   });
+
+   // Files finish scanning in any order, sorting them keeps the index reproducible.
+   std::vector<Scanned_file> files{std::make_move_iterator(scanned_files.begin()),
+                                   std::make_move_iterator(scanned_files.end())};
+
+   std::sort(std::begin(files), std::end(files),
+             [](const Scanned_file& left, const Scanned_file& right) {
+                return left.path < right.path;
+             });
+
+   std::string strings;
+   std::vector<std::uint32_t> file_table;
+   std::vector<Index_entry> entries;
+
+   const auto add_string = [&strings](std::string_view string) {
+      const auto offset = static_cast<std::uint32_t>(strings.size());
+
+      strings += string;
+
+      return offset;
+   };
+
+   for (std::uint32_t file_index = 0; file_index < files.size(); ++file_index) {
+      const auto& file = files[file_index];
+
+      file_table.push_back(add_string(file.path));
+      file_table.push_back(static_cast<std::uint32_t>(file.path.size()));
+
+      for (const auto& chunk : file.chunks) {
+         entries.push_back({chunk.content_hash, chunk.name_hash, add_string(chunk.name),
+                            static_cast<std::uint32_t>(chunk.name.size()), file_index,
+                            chunk.magic_number, chunk.offset, chunk.size,
+                            chunk.parent_offset});
+      }
+   }
+
+   std::sort(std::begin(entries), std::end(entries),
+             [](const Index_entry& left, const Index_entry& right) {
+                return std::tie(left.name_hash, left.file, left.offset) <
+                       std::tie(right.name_hash, right.file, right.offset);
+             });
+
+   std::vector<std::uint32_t> hash_order(entries.size());
+
+   std::iota(std::begin(hash_order), std::end(hash_order), std::uint32_t{0});
+   std::sort(std::begin(hash_order), std::end(hash_order),
+             [&entries](const std::uint32_t left, const std::uint32_t right) {
+                return entries[left].content_hash < entries[right].content_hash;
+             });
+
+   const Index_header header{index_magic, index_version,
+                             static_cast<std::uint32_t>(files.size()),
+                             static_cast<std::uint32_t>(entries.size()),
+                             static_cast<std::uint32_t>(strings.size())};
+
+   std::string buffer;
+
+   buffer += view_pod_as_string(header);
+   buffer += view_pod_span_as_string(gsl::span<const Index_entry>{entries});
+   buffer += view_pod_span_as_string(gsl::span<const std::uint32_t>{hash_order});
+   buffer += view_pod_span_as_string(gsl::span<const std::uint32_t>{file_table});
+   buffer += strings;
+
+   save_file_atomically(index_file, buffer);
+
+   logger::info("Indexed "s, entries.size(), " chunks from "s, files.size(),
+                " files into \""s, index_file.u8string(), '\"');
+}
+
+Chunk_index::Chunk_index(const fs::path& index_file) : _file{index_file}
+{
+   const auto bytes = _file.bytes();
+
+   if (static_cast<std::size_t>(bytes.size()) < sizeof(Index_header)) {
+      throw std::runtime_error{"File is too small to be a chunk index."};
+   }
+
+   Index_header header;
+   std::memcpy(&header, bytes.data(), sizeof(Index_header));
+
+   if (header.magic != index_magic || header.version != index_version) {
+      throw std::runtime_error{"File is not a chunk index or is from another version."};
+   }
+
+   const std::size_t entries_size = header.entry_count * sizeof(Index_entry);
+   const std::size_t hash_order_size = header.entry_count * sizeof(std::uint32_t);
+   const std::size_t files_size = header.file_count * 2 * sizeof(std::uint32_t);
+
+   if (static_cast<std::size_t>(bytes.size()) < sizeof(Index_header) + entries_size +
+                                                   hash_order_size + files_size +
+                                                   header.strings_size) {
+      throw std::runtime_error{"Chunk index is truncated."};
+   }
+
+   auto head = bytes.data() + sizeof(Index_header);
+
+   _entries = {reinterpret_cast<const Index_entry*>(head), header.entry_count};
+   head += entries_size;
+
+   _hash_order = {reinterpret_cast<const std::uint32_t*>(head), header.entry_count};
+   head += hash_order_size;
+
+   _files = {reinterpret_cast<const std::uint32_t*>(head), header.file_count * 2};
+   head += files_size;
+
+   _strings = {reinterpret_cast<const char*>(head), header.strings_size};
+}
+
+auto Chunk_index::find(std::string_view name_or_hash) const -> std::vector<Index_match>
+{
+   std::vector<Index_match> matches;
+
+   if (is_hash_string(name_or_hash)) {
+      const std::uint64_t hash = std::stoull(std::string{name_or_hash}, nullptr, 16);
+
+      const auto hash_less = [this](std::uint32_t index, std::uint64_t value) {
+         return _entries[index].content_hash < value;
+      };
+
+      auto it = std::lower_bound(std::cbegin(_hash_order), std::cend(_hash_order), hash,
+                                 hash_less);
+
+      for (; it != std::cend(_hash_order) && _entries[*it].content_hash == hash; ++it) {
+         matches.emplace_back(match(_entries[*it]));
+      }
+
+      return matches;
+   }
+
+   const auto name_hash = fnv_1a_hash(name_or_hash);
+
+   auto it = std::lower_bound(std::cbegin(_entries), std::cend(_entries), name_hash,
+                              [](const Index_entry& entry, const std::uint32_t hash) {
+                                 return entry.name_hash < hash;
+                              });
+
+   for (; it != std::cend(_entries) && it->name_hash == name_hash; ++it) {
+      const auto entry_name = string(it->name_offset, it->name_length);
+
+      // Unknown level names are stored as their hash in hex, which can only be matched
+      // by hash. Known names are compared in full so hash collisions are not matched.
+      const bool name_known = fnv_1a_hash(entry_name) == it->name_hash;
+
+      if (name_known && !equals_ignoring_case(entry_name, name_or_hash)) continue;
+
+      matches.emplace_back(match(*it));
+   }
+
+   return matches;
+}
+
+auto Chunk_index::match(const Index_entry& entry) const -> Index_match
+{
+   const auto file = entry.file * 2;
+
+   return {std::string{string(_files[file], _files[file + 1])},
+           std::string{string(entry.name_offset, entry.name_length)},
+           entry.magic_number,
+           entry.offset,
+           entry.size,
+           entry.parent_offset,
+           entry.content_hash};
+}
+
+auto Chunk_index::string(const std::uint32_t offset, const std::uint32_t length) const
+   -> std::string_view
+{
+   return _strings.substr(offset, length);
+}
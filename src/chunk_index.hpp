@@ -0,0 +1,82 @@
+#pragma once
+
+#include "magic_number.hpp"
+#include "mapped_file.hpp"
+#include "ucfb_reader.hpp"
+
+#include <gsl/gsl>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! \brief A chunk found in a Chunk_index.
+struct Index_match {
+   std::string input_file;
+   std::string name;
+   Magic_number magic_number;
+   std::uint32_t offset;
+   std::uint32_t size;
+   std::uint32_t parent_offset;
+   std::uint64_t content_hash;
+};
+
+//! \brief The on disk layout of an entry in a chunk index.
+struct Index_entry {
+   std::uint64_t content_hash;
+   std::uint32_t name_hash;
+   std::uint32_t name_offset;
+   std::uint32_t name_length;
+   std::uint32_t file;
+   Magic_number magic_number;
+   std::uint32_t offset;
+   std::uint32_t size;
+   std::uint32_t parent_offset;
+};
+
+static_assert(sizeof(Index_entry) == 40);
+
+//! \brief Gets the names a chunk is known by, from its NAME child or for object classes
+//! its TYPE and BASE children. Empty if the chunk has no name.
+auto chunk_names(Ucfb_reader chunk) -> std::vector<std::string>;
+
+//! \brief Scans input files and saves an index of their top level and lvl_ child chunks.
+//!
+//! Chunks are indexed by the contents of their NAME child, or their TYPE and BASE
+//! children for object classes, and by a hash of their contents. Only chunk headers
+//! and those few children are read, so this is far quicker than extracting the files.
+//! Input files are scanned in parallel.
+//!
+//! \param inputs The paths and patterns of the files to index.
+//! \param index_file The file to save the index to.
+void build_chunk_index(const std::vector<std::string>& inputs,
+                       const std::filesystem::path& index_file);
+
+//! \brief A memory mapped index saved by build_chunk_index.
+//!
+//! Entries are kept sorted by name hash, with a second order sorted by content hash,
+//! so a lookup is a binary search of the mapped file and nothing is loaded up front.
+class Chunk_index {
+public:
+   //! \exception std::runtime_error Thrown when the file is not a valid index.
+   explicit Chunk_index(const std::filesystem::path& index_file);
+
+   //! \brief Finds the chunks with a name, compared without case, or with a content
+   //! hash given as 16 hex digits.
+   auto find(std::string_view name_or_hash) const -> std::vector<Index_match>;
+
+private:
+   auto match(const Index_entry& entry) const -> Index_match;
+
+   auto string(const std::uint32_t offset, const std::uint32_t length) const
+      -> std::string_view;
+
+   Mapped_file _file;
+
+   gsl::span<const Index_entry> _entries;
+   gsl::span<const std::uint32_t> _hash_order;
+   gsl::span<const std::uint32_t> _files;
+   std::string_view _strings;
+};
@@ -1,10 +1,12 @@
 
 #include "chunk_processor.hpp"
 #include "chunk_handlers.hpp"
+#include "error_report.hpp"
 #include "file_saver.hpp"
+#include "logger.hpp"
 #include "magic_number.hpp"
 #include "string_helpers.hpp"
-#include "synced_cout.hpp"
+#include "swbf_fnv_hashes.hpp"
 #include "type_pun.hpp"
 
 #include "tbb/task_group.h"
@@ -22,6 +24,7 @@ struct Args_pack {
    Ucfb_reader chunk;
    Ucfb_reader parent_reader;
    const App_options& app_options;
+   const Input_format input_format;
    File_saver& file_saver;
    msh::Builders_map& msh_builders;
 };
@@ -124,12 +127,15 @@ const auto chunk_processors = Chunk_processor_map{
    // Parent Chunks
    {"ucfb"_mn,
     {Input_platform::pc, Game_version::swbf_ii,
-     [](Args_pack args) { handle_ucfb(args.chunk, args.app_options, args.file_saver); }}},
+     [](Args_pack args) {
+        handle_ucfb(args.chunk, args.app_options, args.input_format, args.file_saver);
+     }}},
 
    {"lvl_"_mn,
     {Input_platform::pc, Game_version::swbf_ii,
      [](Args_pack args) {
-        handle_lvl_child(args.chunk, args.app_options, args.file_saver);
+        handle_lvl_child(args.chunk, args.app_options, args.input_format,
+                         args.file_saver);
      }}},
 
    // Class Chunks
@@ -293,7 +299,12 @@ const auto chunk_processors = Chunk_processor_map{
      [](Args_pack args) { handle_zaabin(args.chunk, args.file_saver); }}},
    {"zaf_"_mn,
     {Input_platform::pc, Game_version::swbf_ii,
-     [](Args_pack args) { handle_binary(args.chunk, args.file_saver, ".zafbin"_sv); }}},
+     [](Args_pack args) { handle_zafbin(args.chunk, args.file_saver); }}},
+
+   // Sound chunks, which are identified by the hash of their name.
+   {static_cast<Magic_number>("SampleBank"_fnv),
+    {Input_platform::pc, Game_version::swbf_ii,
+     [](Args_pack args) { handle_sound_bank(args.chunk, args.file_saver); }}},
 
    // Ignored Chunks, for which we want no output at all.
    {"gmod"_mn, {Input_platform::pc, Game_version::swbf_ii, ignore_chunk}},
@@ -302,21 +313,25 @@ const auto chunk_processors = Chunk_processor_map{
 }
 
 void process_chunk(Ucfb_reader chunk, Ucfb_reader parent_reader,
-                   const App_options& app_options, File_saver& file_saver,
-                   msh::Builders_map& msh_builders)
+                   const App_options& app_options, const Input_format input_format,
+                   File_saver& file_saver, msh::Builders_map& msh_builders)
 {
    const auto processor = chunk_processors.lookup(
-      chunk.magic_number(), app_options.input_platform(), app_options.game_version());
+      chunk.magic_number(), input_format.platform, input_format.game_version);
 
    if (processor) {
       try {
-         processor({chunk, parent_reader, app_options, file_saver, msh_builders});
+         processor(
+            {chunk, parent_reader, app_options, input_format, file_saver, msh_builders});
       }
       catch (const std::exception& e) {
-         synced_cout::print("Error: Exception occured while processing chunk.\n"
-                            "   Type: "s,
-                            view_pod_as_string(chunk.magic_number()), "\n   Size: "s,
-                            chunk.size(), "\n   Message: "s, e.what(), '\n');
+         file_saver.mark_incomplete();
+
+         error_report::add_chunk_error(chunk, "process_chunk"_sv, e.what());
+
+         logger::error("Exception occured while processing chunk.\n   Type: "s,
+                       view_pod_as_string(chunk.magic_number()), "\n   Size: "s,
+                       chunk.size(), "\n   Message: "s, e.what());
       }
    }
    else {
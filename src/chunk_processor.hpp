@@ -7,11 +7,12 @@ namespace chunks {
 struct Unknown;
 }
 class App_options;
+struct Input_format;
 class File_saver;
 namespace tbb {
 class task_group;
 }
 
 void process_chunk(Ucfb_reader chunk, Ucfb_reader parent_reader,
-                   const App_options& app_options, File_saver& file_saver,
-                   msh::Builders_map& msh_builders);
+                   const App_options& app_options, const Input_format input_format,
+                   File_saver& file_saver, msh::Builders_map& msh_builders);
@@ -0,0 +1,351 @@
+#include "config_tree.hpp"
+#include "string_helpers.hpp"
+#include "swbf_fnv_hashes.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace std::literals;
+
+namespace {
+
+constexpr auto precision_cutoff = 0.00001f;
+
+inline std::string cast_number_value(const float number)
+{
+   const auto fraction = std::remainder(number, 1.0f);
+   const auto absolute_fraction = std::abs(fraction);
+
+   if (absolute_fraction < precision_cutoff)
+      return std::to_string(static_cast<std::int64_t>(number));
+
+   return std::to_string(number);
+}
+
+bool is_string_data(Ucfb_reader_strict<"DATA"_mn> data)
+{
+   data.consume(4);
+
+   const auto element_count = data.read_trivial_unaligned<std::uint8_t>();
+
+   if (element_count == 0) return false;
+
+   const auto str_sizes_size = data.read_trivial_unaligned<std::uint32_t>();
+
+   if (str_sizes_size / 4 != element_count) return false;
+
+   const auto str_sizes = data.read_array_unaligned<std::uint32_t>(element_count);
+
+   const std::size_t str_array_size = str_sizes[element_count - 1];
+
+   return (data.size() == 9 + str_sizes_size + str_array_size);
+}
+
+bool is_hash_data(Ucfb_reader_strict<"DATA"_mn> data)
+{
+   const std::array<std::uint32_t, 7> hashes = {
+      0x156b70a1, // GrassPatch
+      0xaaea5743, // File
+      0x0e0d9594, // Sound
+      0xc28f0c96, // CollisionSound
+      0x84874d36, // Path
+      0x6850acc6, // BorderOdf
+      0x6a6fb399  // LeafPatch
+   };
+
+   const auto data_hash = data.read_trivial<std::uint32_t>();
+   const auto element_count = data.read_trivial_unaligned<std::uint8_t>();
+
+   return ((std::find(std::cbegin(hashes), std::cend(hashes), data_hash) !=
+            std::cend(hashes)) &&
+           element_count > 0);
+}
+
+bool is_hybrid_data(Ucfb_reader_strict<"DATA"_mn> data)
+{
+   data.consume(4);
+
+   const auto element_count = data.read_trivial_unaligned<std::uint8_t>();
+
+   if (element_count != 2) return false;
+
+   return (data.size() != (element_count * sizeof(float) + 9));
+}
+
+bool is_float_data(Ucfb_reader_strict<"DATA"_mn> data)
+{
+   data.consume(4);
+
+   const auto element_count = data.read_trivial_unaligned<std::uint8_t>();
+
+   return ((element_count > 0) && (data.size() == (element_count * sizeof(float) + 9)));
+}
+
+void read_string_data(Ucfb_reader_strict<"DATA"_mn> data, Config_node& node)
+{
+   node.key_hash = data.read_trivial<std::uint32_t>();
+
+   const auto element_count = data.read_trivial_unaligned<std::uint8_t>();
+   const auto str_sizes_size = data.read_trivial_unaligned<std::uint32_t>();
+   const auto str_sizes = data.read_array_unaligned<std::uint32_t>(element_count);
+
+   node.values.reserve(element_count);
+
+   while (data) {
+      node.values.emplace_back(data.read_string_unaligned());
+   }
+}
+
+void read_hash_data(Ucfb_reader_strict<"DATA"_mn> data, Config_node& node)
+{
+   node.key_hash = data.read_trivial<std::uint32_t>();
+
+   const auto element_count = data.read_trivial_unaligned<std::uint8_t>();
+   const auto value_hash = data.read_trivial_unaligned<std::uint32_t>();
+
+   node.values.reserve(element_count);
+   node.values.emplace_back(Config_hash{value_hash});
+
+   for (std::size_t i = 1; i < element_count; ++i) {
+      node.values.emplace_back(data.read_trivial_unaligned<float>());
+   }
+}
+
+void read_hybrid_data(Ucfb_reader_strict<"DATA"_mn> data, Config_node& node)
+{
+   node.key_hash = data.read_trivial<std::uint32_t>();
+
+   const auto element_count = data.read_trivial_unaligned<std::uint8_t>();
+
+   const auto string_index = data.read_trivial_unaligned<std::uint32_t>();
+
+   const auto value = data.read_trivial_unaligned<float>();
+
+   const auto string_size = data.read_trivial_unaligned<std::uint32_t>();
+
+   node.values.emplace_back(data.read_string_unaligned());
+   node.values.emplace_back(value);
+}
+
+void read_float_data(Ucfb_reader_strict<"DATA"_mn> data, Config_node& node)
+{
+   node.key_hash = data.read_trivial<std::uint32_t>();
+
+   const auto element_count = data.read_trivial_unaligned<std::uint8_t>();
+
+   node.values.reserve(element_count);
+
+   for (std::size_t i = 0; i < element_count; ++i) {
+      node.values.emplace_back(data.read_trivial_unaligned<float>());
+   }
+}
+
+void read_tag_data(Ucfb_reader_strict<"DATA"_mn> data, Config_node& node)
+{
+   node.key_hash = data.read_trivial<std::uint32_t>();
+}
+
+Config_node read_data(Ucfb_reader_strict<"DATA"_mn> data, bool strings_are_hashed)
+{
+   Config_node node;
+
+   if (is_string_data(data)) {
+      read_string_data(data, node);
+   }
+   else if (strings_are_hashed && is_hash_data(data)) {
+      read_hash_data(data, node);
+   }
+   else if (is_hybrid_data(data)) {
+      read_hybrid_data(data, node);
+   }
+   else if (is_float_data(data)) {
+      read_float_data(data, node);
+   }
+   else {
+      read_tag_data(data, node);
+   }
+
+   return node;
+}
+
+// Reads the DATA and SCOP children of a chunk. A scope belongs to the DATA chunk
+// directly before it.
+void read_scope(Ucfb_reader scope, bool strings_are_hashed,
+                std::vector<Config_node>& nodes)
+{
+   bool last_was_data = false;
+
+   while (scope) {
+      const auto child = scope.read_child();
+
+      if (child.magic_number() == "DATA"_mn) {
+         nodes.emplace_back(
+            read_data(Ucfb_reader_strict<"DATA"_mn>{child}, strings_are_hashed));
+
+         last_was_data = true;
+      }
+      else if (child.magic_number() == "SCOP"_mn) {
+         if (!last_was_data) {
+            auto& keyless = nodes.emplace_back();
+            keyless.has_key = false;
+         }
+
+         nodes.back().has_scope = true;
+
+         read_scope(child, strings_are_hashed, nodes.back().children);
+
+         last_was_data = false;
+      }
+   }
+}
+
+void append_value(const Config_value& value, std::string& buffer)
+{
+   if (const auto number = std::get_if<float>(&value); number) {
+      buffer += cast_number_value(*number);
+   }
+   else if (const auto string = std::get_if<std::string_view>(&value); string) {
+      buffer += '\"';
+      buffer += *string;
+      buffer += '\"';
+   }
+   else if (const auto hash = std::get_if<Config_hash>(&value); hash) {
+      buffer += '\"';
+      buffer += lookup_fnv_hash(hash->value);
+      buffer += '\"';
+   }
+}
+
+void append_nodes(const std::vector<Config_node>& nodes,
+                  const std::size_t indention_level, std::string& buffer)
+{
+   for (const auto& node : nodes) {
+      if (node.has_key) {
+         buffer.append(indention_level, '\t');
+         buffer += format_config_node(node);
+         buffer += node.has_scope ? "\n"_sv : ";\n"_sv;
+      }
+
+      if (node.has_scope) {
+         buffer.append(indention_level, '\t');
+         buffer += "{\n"_sv;
+
+         append_nodes(node.children, indention_level + 1, buffer);
+
+         buffer.append(indention_level, '\t');
+         buffer += "}\n\n"_sv;
+      }
+   }
+}
+
+// Gathers the nodes a query can match at one level. Keyless scopes are looked through,
+// their children count as being at the same level.
+void gather_level(const std::vector<Config_node>& nodes,
+                  std::vector<const Config_node*>& level)
+{
+   for (const auto& node : nodes) {
+      if (node.has_key) {
+         level.push_back(&node);
+      }
+      else {
+         gather_level(node.children, level);
+      }
+   }
+}
+}
+
+Config_tree::Config_tree(Ucfb_reader config, const bool strings_are_hashed)
+{
+   _name_hash = config.read_child_strict<"NAME"_mn>().read_trivial<std::uint32_t>();
+
+   read_scope(config, strings_are_hashed, _nodes);
+}
+
+std::uint32_t Config_tree::name_hash() const noexcept
+{
+   return _name_hash;
+}
+
+auto Config_tree::nodes() const noexcept -> const std::vector<Config_node>&
+{
+   return _nodes;
+}
+
+auto Config_tree::query(std::string_view path) const -> std::vector<const Config_node*>
+{
+   std::vector<const Config_node*> matches;
+   gather_level(_nodes, matches);
+
+   while (!path.empty()) {
+      const auto separator = path.find('.');
+      const auto key = path.substr(0, separator);
+
+      path = (separator == path.npos) ? ""_sv : path.substr(separator + 1);
+
+      const bool wildcard = (key == "*"_sv);
+      const auto key_hash = fnv_1a_hash(key);
+
+      std::vector<const Config_node*> next;
+
+      for (const auto node : matches) {
+         if (!wildcard && node->key_hash != key_hash) continue;
+
+         if (path.empty()) {
+            next.push_back(node);
+         }
+         else {
+            gather_level(node->children, next);
+         }
+      }
+
+      matches = std::move(next);
+   }
+
+   return matches;
+}
+
+auto Config_tree::to_string() const -> std::string
+{
+   std::string buffer;
+   buffer.reserve(16384);
+
+   append_nodes(_nodes, 0, buffer);
+
+   return buffer;
+}
+
+auto format_config_node(const Config_node& node) -> std::string
+{
+   std::string line;
+
+   line += lookup_fnv_hash(node.key_hash);
+   line += '(';
+
+   for (std::size_t i = 0; i < node.values.size(); ++i) {
+      if (i != 0) line += ", "_sv;
+
+      append_value(node.values[i], line);
+   }
+
+   line += ')';
+
+   return line;
+}
+
+bool is_config_chunk(const Magic_number magic_number) noexcept
+{
+   constexpr std::array<Magic_number, 12> config_chunks{
+      "fx__"_mn, "sky_"_mn, "prp_"_mn, "bnd_"_mn, "lght"_mn, "port"_mn,
+      "path"_mn, "comb"_mn, "sanm"_mn, "hud_"_mn, "load"_mn, "mcfg"_mn};
+
+   return std::find(config_chunks.cbegin(), config_chunks.cend(), magic_number) !=
+          config_chunks.cend();
+}
+
+bool config_strings_are_hashed(const Magic_number magic_number) noexcept
+{
+   return magic_number == "prp_"_mn || magic_number == "bnd_"_mn;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "magic_number.hpp"
+#include "ucfb_reader.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+//! \brief A hashed value in a config, such as a file or sound name.
+struct Config_hash {
+   std::uint32_t value;
+};
+
+//! \brief A value of a config node. Strings view the input file the config was read from.
+using Config_value = std::variant<float, std::string_view, Config_hash>;
+
+//! \brief A DATA chunk of a config and the scope that follows it, if there is one.
+//!
+//! A scope that does not follow a DATA chunk has a node of its own with no key.
+struct Config_node {
+   std::uint32_t key_hash = 0;
+   bool has_key = true;
+
+   std::vector<Config_value> values;
+
+   bool has_scope = false;
+   std::vector<Config_node> children;
+};
+
+//! \brief A config chunk (fx__, sky_, hud_, load and the like) read into a tree.
+//!
+//! Nothing is written out or formatted to build the tree. Keys are kept as the hashes
+//! stored in the chunk and are matched against hashed query paths, so looking a value up
+//! never needs the name of a key.
+class Config_tree {
+public:
+   //! \brief Reads a config chunk. The tree views the chunk's bytes and must not outlive
+   //! them.
+   //!
+   //! \param config The config chunk, starting with its NAME child.
+   //! \param strings_are_hashed If the chunk stores some string values as hashes.
+   //!
+   //! \exception std::runtime_error Thrown when a chunk runs past its parent.
+   Config_tree(Ucfb_reader config, const bool strings_are_hashed);
+
+   std::uint32_t name_hash() const noexcept;
+
+   auto nodes() const noexcept -> const std::vector<Config_node>&;
+
+   //! \brief Finds the nodes at a path of keys separated by '.', such as
+   //! "SkyInfo.FogRange". Keys are compared case insensitively and '*' matches any key.
+   auto query(std::string_view path) const -> std::vector<const Config_node*>;
+
+   //! \brief Formats the tree as the text of a config file.
+   auto to_string() const -> std::string;
+
+private:
+   std::uint32_t _name_hash = 0;
+   std::vector<Config_node> _nodes;
+};
+
+//! \brief Formats a node's key and values as they would appear in a config file.
+auto format_config_node(const Config_node& node) -> std::string;
+
+bool is_config_chunk(const Magic_number magic_number) noexcept;
+
+//! \brief If a config chunk stores some of its string values as hashes.
+bool config_strings_are_hashed(const Magic_number magic_number) noexcept;
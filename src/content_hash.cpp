@@ -0,0 +1,105 @@
+#include "content_hash.hpp"
+
+#include <cstring>
+
+namespace {
+
+constexpr std::uint64_t prime_1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t prime_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t prime_3 = 0x165667B19E3779F9ull;
+constexpr std::uint64_t prime_4 = 0x85EBCA77C2B2AE63ull;
+constexpr std::uint64_t prime_5 = 0x27D4EB2F165667C5ull;
+
+constexpr std::uint64_t rotl(const std::uint64_t value, const int amount) noexcept
+{
+   return (value << amount) | (value >> (64 - amount));
+}
+
+inline std::uint64_t read_u64(const std::byte* const bytes) noexcept
+{
+   std::uint64_t value;
+   std::memcpy(&value, bytes, sizeof(value));
+
+   return value;
+}
+
+inline std::uint32_t read_u32(const std::byte* const bytes) noexcept
+{
+   std::uint32_t value;
+   std::memcpy(&value, bytes, sizeof(value));
+
+   return value;
+}
+
+constexpr std::uint64_t round(std::uint64_t accumulator, const std::uint64_t lane) noexcept
+{
+   accumulator += lane * prime_2;
+   accumulator = rotl(accumulator, 31);
+
+   return accumulator * prime_1;
+}
+
+constexpr std::uint64_t merge_round(std::uint64_t accumulator,
+                                    const std::uint64_t value) noexcept
+{
+   accumulator ^= round(0, value);
+
+   return accumulator * prime_1 + prime_4;
+}
+}
+
+std::uint64_t content_hash(gsl::span<const std::byte> bytes,
+                           const std::uint64_t seed) noexcept
+{
+   const std::byte* head = bytes.data();
+   const std::byte* const end = bytes.data() + bytes.size();
+   const auto length = static_cast<std::uint64_t>(bytes.size());
+
+   std::uint64_t hash;
+
+   if (length >= 32) {
+      std::uint64_t lanes[4] = {seed + prime_1 + prime_2, seed + prime_2, seed,
+                                seed - prime_1};
+
+      for (; (end - head) >= 32; head += 32) {
+         lanes[0] = round(lanes[0], read_u64(head));
+         lanes[1] = round(lanes[1], read_u64(head + 8));
+         lanes[2] = round(lanes[2], read_u64(head + 16));
+         lanes[3] = round(lanes[3], read_u64(head + 24));
+      }
+
+      hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) +
+             rotl(lanes[3], 18);
+
+      for (const auto lane : lanes) hash = merge_round(hash, lane);
+   }
+   else {
+      hash = seed + prime_5;
+   }
+
+   hash += length;
+
+   for (; (end - head) >= 8; head += 8) {
+      hash ^= round(0, read_u64(head));
+      hash = rotl(hash, 27) * prime_1 + prime_4;
+   }
+
+   if ((end - head) >= 4) {
+      hash ^= static_cast<std::uint64_t>(read_u32(head)) * prime_1;
+      hash = rotl(hash, 23) * prime_2 + prime_3;
+      head += 4;
+   }
+
+   for (; head < end; ++head) {
+      hash ^= static_cast<std::uint64_t>(*head) * prime_5;
+      hash = rotl(hash, 11) * prime_1;
+   }
+
+   hash ^= hash >> 33;
+   hash *= prime_2;
+   hash ^= hash >> 29;
+   hash *= prime_3;
+   hash ^= hash >> 32;
+
+   return hash;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <gsl/gsl>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// xxHash64, used to fingerprint chunk contents. Not cryptographic, only fast.
+std::uint64_t content_hash(gsl::span<const std::byte> bytes,
+                           const std::uint64_t seed = 0) noexcept;
+
+inline std::uint64_t content_hash(std::string_view string,
+                                  const std::uint64_t seed = 0) noexcept
+{
+   return content_hash({reinterpret_cast<const std::byte*>(string.data()),
+                        static_cast<gsl::span<const std::byte>::index_type>(
+                           string.size())},
+                       seed);
+}
+
+inline std::string content_hash_string(const std::uint64_t hash)
+{
+   constexpr auto digits = "0123456789abcdef";
+
+   std::string string(16, '0');
+
+   for (auto i = 0; i < 16; ++i) {
+      string[15 - i] = digits[(hash >> (i * 4)) & 0xfu];
+   }
+
+   return string;
+}
@@ -0,0 +1,398 @@
+#include "coordinator.hpp"
+#include "error_report.hpp"
+#include "input_discovery.hpp"
+#include "logger.hpp"
+#include "string_helpers.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+namespace fs = std::filesystem;
+using namespace std::literals;
+
+namespace {
+
+constexpr auto reply_prefix = "swbf-unmunge-worker:"_sv;
+constexpr auto succeeded_status = "done"_sv;
+constexpr auto failed_status = "failed"_sv;
+constexpr auto error_status = "error"_sv;
+
+// How many workers a single file may take down before it is given up on.
+constexpr int max_attempts = 2;
+
+class Handle {
+public:
+   Handle() = default;
+
+   explicit Handle(HANDLE handle) noexcept : _handle{handle} {}
+
+   Handle(const Handle&) = delete;
+   Handle& operator=(const Handle&) = delete;
+
+   Handle(Handle&& other) noexcept : _handle{std::exchange(other._handle, nullptr)} {}
+
+   Handle& operator=(Handle&& other) noexcept
+   {
+      std::swap(_handle, other._handle);
+
+      return *this;
+   }
+
+   ~Handle()
+   {
+      reset();
+   }
+
+   HANDLE get() const noexcept
+   {
+      return _handle;
+   }
+
+   void reset() noexcept
+   {
+      if (_handle) CloseHandle(_handle);
+
+      _handle = nullptr;
+   }
+
+private:
+   HANDLE _handle = nullptr;
+};
+
+class Worker_process {
+public:
+   explicit Worker_process(std::wstring command_line)
+   {
+      // Spawning is serialized so a worker never inherits the pipe ends of another, which
+      // would keep a crashed worker's output pipe from ever reporting its end.
+      static std::mutex spawn_mutex;
+      std::lock_guard<std::mutex> lock{spawn_mutex};
+
+      SECURITY_ATTRIBUTES security{sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+
+      HANDLE read_end = nullptr;
+      HANDLE write_end = nullptr;
+
+      if (!CreatePipe(&read_end, &write_end, &security, 0)) {
+         throw std::runtime_error{"Unable to create worker input pipe."};
+      }
+
+      Handle child_input{read_end};
+      _input = Handle{write_end};
+
+      if (!CreatePipe(&read_end, &write_end, &security, 0)) {
+         throw std::runtime_error{"Unable to create worker output pipe."};
+      }
+
+      Handle child_output{write_end};
+      _output = Handle{read_end};
+
+      SetHandleInformation(_input.get(), HANDLE_FLAG_INHERIT, 0);
+      SetHandleInformation(_output.get(), HANDLE_FLAG_INHERIT, 0);
+
+      STARTUPINFOW startup_info{};
+      startup_info.cb = sizeof(STARTUPINFOW);
+      startup_info.dwFlags = STARTF_USESTDHANDLES;
+      startup_info.hStdInput = child_input.get();
+      startup_info.hStdOutput = child_output.get();
+      startup_info.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+      PROCESS_INFORMATION process_info{};
+
+      if (!CreateProcessW(nullptr, command_line.data(), nullptr, nullptr, TRUE, 0,
+                          nullptr, nullptr, &startup_info, &process_info)) {
+         throw std::runtime_error{"Unable to start worker process."};
+      }
+
+      CloseHandle(process_info.hThread);
+      _process = Handle{process_info.hProcess};
+   }
+
+   bool send(std::string_view line) noexcept
+   {
+      while (!line.empty()) {
+         DWORD written = 0;
+
+         if (!WriteFile(_input.get(), line.data(), static_cast<DWORD>(line.size()),
+                        &written, nullptr)) {
+            return false;
+         }
+
+         line.remove_prefix(written);
+      }
+
+      return true;
+   }
+
+   bool read_line(std::string& line)
+   {
+      for (;;) {
+         if (const auto end = _buffer.find('\n'); end != _buffer.npos) {
+            line.assign(_buffer, 0, end);
+            _buffer.erase(0, end + 1);
+
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+
+            return true;
+         }
+
+         char chunk[4096];
+         DWORD read = 0;
+
+         if (!ReadFile(_output.get(), chunk, sizeof(chunk), &read, nullptr)) return false;
+         if (read == 0) return false;
+
+         _buffer.append(chunk, read);
+      }
+   }
+
+   // Closes the worker's input, which tells it to exit, and waits for it to do so.
+   DWORD finish() noexcept
+   {
+      _input.reset();
+
+      WaitForSingleObject(_process.get(), INFINITE);
+
+      DWORD exit_code = 0;
+      GetExitCodeProcess(_process.get(), &exit_code);
+
+      return exit_code;
+   }
+
+private:
+   Handle _process;
+   Handle _input;
+   Handle _output;
+
+   std::string _buffer;
+};
+
+struct Work_item {
+   std::string file;
+   int attempts = 0;
+};
+
+class Work_queue {
+public:
+   // Files are handed out largest first, so the last files left running are short ones.
+   explicit Work_queue(const std::vector<std::string>& files)
+   {
+      std::vector<std::pair<std::uintmax_t, std::string>> sized_files;
+      sized_files.reserve(files.size());
+
+      for (const auto& file : files) {
+         std::error_code error;
+         const auto size =
+            fs::is_regular_file(file, error) ? fs::file_size(file, error) : 0;
+
+         sized_files.emplace_back(error ? 0 : size, file);
+      }
+
+      std::stable_sort(std::begin(sized_files), std::end(sized_files),
+                       [](const auto& left, const auto& right) {
+                          return left.first > right.first;
+                       });
+
+      for (auto& file : sized_files) _items.push_back({std::move(file.second)});
+   }
+
+   auto pop() -> std::optional<Work_item>
+   {
+      std::lock_guard<std::mutex> lock{_mutex};
+
+      if (_items.empty()) return std::nullopt;
+
+      auto item = std::move(_items.front());
+      _items.pop_front();
+
+      return item;
+   }
+
+   void push(Work_item item)
+   {
+      std::lock_guard<std::mutex> lock{_mutex};
+
+      _items.push_back(std::move(item));
+   }
+
+   auto size() -> std::size_t
+   {
+      std::lock_guard<std::mutex> lock{_mutex};
+
+      return _items.size();
+   }
+
+private:
+   std::mutex _mutex;
+   std::deque<Work_item> _items;
+};
+
+struct Run_stats {
+   std::atomic_size_t succeeded{0};
+   std::atomic_size_t failed{0};
+   std::atomic_size_t crashes{0};
+};
+
+// Passes on the worker's output until it replies, returns false if it exited first.
+bool await_reply(Worker_process& worker, Run_stats& stats)
+{
+   std::string line;
+
+   while (worker.read_line(line)) {
+      std::string_view view{line};
+
+      if (view.substr(0, reply_prefix.size()) != reply_prefix) {
+         logger::relay(line);
+
+         continue;
+      }
+
+      view.remove_prefix(reply_prefix.size() + 1);
+
+      const auto [status, rest] = split_string(view, ' ');
+
+      if (status == error_status) {
+         try {
+            error_report::add(error_report::from_line(rest));
+         }
+         catch (const std::exception&) {
+            logger::relay(line);
+         }
+
+         continue;
+      }
+
+      ++(status == succeeded_status ? stats.succeeded : stats.failed);
+
+      return true;
+   }
+
+   return false;
+}
+
+void drive_worker(const std::wstring& command_line, Work_queue& queue,
+                  Run_stats& stats) noexcept
+{
+   std::optional<Worker_process> worker;
+   std::optional<Work_item> item;
+
+   try {
+      while ((item = queue.pop())) {
+         if (!worker) worker.emplace(command_line);
+
+         if (worker->send(item->file + '\n') && await_reply(*worker, stats)) continue;
+
+         const auto exit_code = worker->finish();
+         worker.reset();
+
+         ++stats.crashes;
+         ++item->attempts;
+
+         if (item->attempts < max_attempts) {
+            logger::warning("Worker exited while processing file, retrying.\n   File: "s,
+                            item->file, "\n   Exit Code: "s, exit_code);
+
+            queue.push(std::move(*item));
+         }
+         else {
+            logger::error("Worker exited while processing file, giving up.\n   File: "s,
+                          item->file, "\n   Exit Code: "s, exit_code);
+
+            error_report::add_error(item->file, ""s, "worker"_sv,
+                                    "Worker exited with code "s +
+                                       std::to_string(exit_code));
+
+            ++stats.failed;
+         }
+      }
+
+      if (worker) worker->finish();
+   }
+   catch (std::exception& e) {
+      logger::error("Exception occured while running worker.\n   Message: "s, e.what());
+
+      if (item) queue.push(std::move(*item));
+   }
+}
+}
+
+void run_coordinator(const App_options& options)
+{
+   const auto input_files = find_inputs(options.input_files(),
+                                        options.tool_mode() == Tool_mode::assemble);
+
+   Work_queue queue{input_files};
+   Run_stats stats;
+
+   std::wstring command_line = GetCommandLineW();
+   command_line += L" -worker"_sv;
+
+   const auto worker_count =
+      std::min(static_cast<std::size_t>(options.jobs()), input_files.size());
+
+   std::vector<std::thread> threads;
+   threads.reserve(worker_count);
+
+   for (std::size_t i = 0; i < worker_count; ++i) {
+      threads.emplace_back(drive_worker, std::cref(command_line), std::ref(queue),
+                           std::ref(stats));
+   }
+
+   for (auto& thread : threads) thread.join();
+
+   // A retry can be queued after the other workers found the queue empty and stopped.
+   if (queue.size() != 0) drive_worker(command_line, queue, stats);
+
+   if (const auto unprocessed = queue.size(); unprocessed != 0) {
+      logger::error(unprocessed, " files could not be processed."s);
+
+      error_report::add_error(""s, ""s, "worker"_sv,
+                              std::to_string(unprocessed) +
+                                 " files could not be processed."s);
+
+      stats.failed += unprocessed;
+   }
+
+   logger::info("Processed "s, input_files.size(), " files with "s, worker_count,
+                " workers. "s, stats.succeeded.load(), " succeeded, "s,
+                stats.failed.load(), " failed, "s, stats.crashes.load(),
+                " worker crashes."s);
+}
+
+std::string worker_reply(const bool succeeded, std::string_view file)
+{
+   std::string reply;
+
+   reply += reply_prefix;
+   reply += ' ';
+   reply += succeeded ? succeeded_status : failed_status;
+   reply += ' ';
+   reply += file;
+
+   return reply;
+}
+
+std::string worker_error(const Error_record& error)
+{
+   std::string line;
+
+   line += reply_prefix;
+   line += ' ';
+   line += error_status;
+   line += ' ';
+   line += error_report::to_line(error);
+
+   return line;
+}
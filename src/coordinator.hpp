@@ -0,0 +1,26 @@
+#pragma once
+
+#include "app_options.hpp"
+#include "error_report.hpp"
+
+#include <string>
+#include <string_view>
+
+//! \brief Processes the input files across several worker processes.
+//!
+//! Each worker is a copy of this program started with '-worker' and the same options.
+//! Workers are fed one input file at a time through their standard input, largest files
+//! first, and answer with a line made by worker_reply once they are done with it. Any
+//! other output from a worker is passed through.
+//!
+//! A worker that exits while processing a file is restarted and the file retried. A
+//! summary of the run is printed once all files are done.
+void run_coordinator(const App_options& options);
+
+//! \brief Creates the line a worker writes to tell the coordinator a file is done. It
+//! does not include a trailing newline.
+std::string worker_reply(const bool succeeded, std::string_view file);
+
+//! \brief Creates the line a worker writes to pass an error on to the coordinator. It
+//! does not include a trailing newline.
+std::string worker_error(const Error_record& error);
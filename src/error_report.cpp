@@ -0,0 +1,346 @@
+#include "error_report.hpp"
+#include "file_saver.hpp"
+#include "logger.hpp"
+#include "magic_number.hpp"
+#include "string_helpers.hpp"
+#include "type_pun.hpp"
+
+#include "tbb/concurrent_vector.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace fs = std::filesystem;
+using namespace std::literals;
+
+namespace error_report {
+
+namespace {
+
+struct Source {
+   std::string input_file;
+   gsl::span<const std::byte> bytes;
+};
+
+std::mutex sources_mutex;
+std::vector<Source> sources;
+
+tbb::concurrent_vector<Error_record> records;
+
+auto find_source(const std::byte* const address) -> std::optional<Source>
+{
+   std::lock_guard<std::mutex> lock{sources_mutex};
+
+   for (const auto& source : sources) {
+      const auto begin = source.bytes.data();
+
+      if (address >= begin && address < begin + source.bytes.size()) return source;
+   }
+
+   return std::nullopt;
+}
+
+bool contains(const Ucfb_reader& chunk, const std::byte* const chunk_data) noexcept
+{
+   const auto bytes = chunk.bytes();
+
+   return chunk_data >= bytes.data() && chunk_data <= bytes.data() + bytes.size();
+}
+
+// Finds the path of magic numbers from the root chunk to the chunk whose data starts at
+// chunk_data. Only used once something has gone wrong, so it simply walks the file again.
+void append_chunk_path(Ucfb_reader parent, const std::byte* const chunk_data,
+                       std::string& path)
+{
+   path += view_pod_as_string(parent.magic_number());
+
+   if (parent.bytes().data() == chunk_data) return;
+
+   path += '/';
+
+   if (parent.magic_number() == "lvl_"_mn) parent.consume(8);
+
+   while (parent) {
+      const auto child = parent.read_child();
+
+      if (contains(child, chunk_data)) return append_chunk_path(child, chunk_data, path);
+   }
+
+   path += '?';
+}
+
+auto chunk_path(const Source& source, const std::byte* const chunk_data) -> std::string
+{
+   std::string path;
+
+   try {
+      append_chunk_path(Ucfb_reader{source.bytes}, chunk_data, path);
+   }
+   catch (const std::exception&) {
+      path += '?';
+   }
+
+   return path;
+}
+
+void escape_field(std::string_view field, std::string& out)
+{
+   for (const char c : field) {
+      if (c == '\\') {
+         out += "\\\\"_sv;
+      }
+      else if (c == '\t') {
+         out += "\\t"_sv;
+      }
+      else if (c == '\n') {
+         out += "\\n"_sv;
+      }
+      else {
+         out += c;
+      }
+   }
+}
+
+auto unescape_field(std::string_view field) -> std::string
+{
+   std::string out;
+   out.reserve(field.size());
+
+   for (std::size_t i = 0; i < field.size(); ++i) {
+      if (field[i] != '\\' || i + 1 == field.size()) {
+         out += field[i];
+
+         continue;
+      }
+
+      const char c = field[++i];
+
+      if (c == 't') {
+         out += '\t';
+      }
+      else if (c == 'n') {
+         out += '\n';
+      }
+      else {
+         out += c;
+      }
+   }
+
+   return out;
+}
+
+void append_json_string(std::string_view name, std::string_view value, std::string& out)
+{
+   out += '"';
+   out += name;
+   out += R"(":")"_sv;
+   out += json_escape(value);
+   out += '"';
+}
+}
+
+Source_scope::Source_scope(std::string input_file, gsl::span<const std::byte> bytes)
+   : _begin{bytes.data()}
+{
+   std::lock_guard<std::mutex> lock{sources_mutex};
+
+   sources.push_back({std::move(input_file), bytes});
+}
+
+Source_scope::~Source_scope()
+{
+   std::lock_guard<std::mutex> lock{sources_mutex};
+
+   sources.erase(std::remove_if(std::begin(sources), std::end(sources),
+                                [this](const Source& source) {
+                                   return source.bytes.data() == _begin;
+                                }),
+                 std::end(sources));
+}
+
+void add_chunk_error(const Ucfb_reader& chunk, std::string_view handler,
+                     std::string_view message) noexcept
+{
+   try {
+      Error_record record;
+
+      const auto chunk_data = chunk.bytes().data();
+
+      if (const auto source = find_source(chunk_data); source) {
+         record.input_file = source->input_file;
+         record.chunk_path = chunk_path(*source, chunk_data);
+         record.offset = static_cast<std::size_t>(chunk_data - source->bytes.data()) - 8;
+      }
+
+      record.magic_number = view_pod_as_string(chunk.magic_number());
+      record.handler = handler;
+      record.message = message;
+
+      add(std::move(record));
+   }
+   catch (const std::exception&) {
+   }
+}
+
+void add_error(std::string input_file, std::string chunk_path, std::string_view handler,
+               std::string_view message) noexcept
+{
+   try {
+      Error_record record;
+
+      record.input_file = std::move(input_file);
+      record.chunk_path = std::move(chunk_path);
+      record.handler = handler;
+      record.message = message;
+
+      add(std::move(record));
+   }
+   catch (const std::exception&) {
+   }
+}
+
+void add(Error_record record) noexcept
+{
+   try {
+      records.push_back(std::move(record));
+   }
+   catch (const std::exception&) {
+   }
+}
+
+auto input_file_of(const Ucfb_reader& chunk) -> std::string
+{
+   const auto source = find_source(chunk.bytes().data());
+
+   if (!source) return ""s;
+
+   return source->input_file;
+}
+
+auto offset_of(const Ucfb_reader& chunk) -> std::optional<std::size_t>
+{
+   const auto chunk_data = chunk.bytes().data();
+   const auto source = find_source(chunk_data);
+
+   if (!source) return std::nullopt;
+
+   return static_cast<std::size_t>(chunk_data - source->bytes.data()) - 8;
+}
+
+std::size_t count() noexcept
+{
+   return records.size();
+}
+
+auto records_since(const std::size_t first_record) -> std::vector<Error_record>
+{
+   return {records.begin() + first_record, records.begin() + records.size()};
+}
+
+auto to_line(const Error_record& record) -> std::string
+{
+   std::string line;
+
+   escape_field(record.input_file, line);
+   line += '\t';
+   escape_field(record.chunk_path, line);
+   line += '\t';
+   if (record.offset) line += std::to_string(*record.offset);
+   line += '\t';
+   escape_field(record.magic_number, line);
+   line += '\t';
+   escape_field(record.handler, line);
+   line += '\t';
+   escape_field(record.message, line);
+
+   return line;
+}
+
+auto from_line(std::string_view line) -> Error_record
+{
+   std::vector<std::string> fields;
+
+   for_each_substr(line, '\t', [&](std::string_view field) {
+      fields.push_back(unescape_field(field));
+   });
+
+   // for_each_substr skips an empty last field.
+   if (fields.size() == 5) fields.emplace_back();
+
+   if (fields.size() != 6) throw std::runtime_error{"Malformed error record."};
+
+   Error_record record;
+
+   record.input_file = std::move(fields[0]);
+   record.chunk_path = std::move(fields[1]);
+   if (!fields[2].empty()) record.offset = std::stoull(fields[2]);
+   record.magic_number = std::move(fields[3]);
+   record.handler = std::move(fields[4]);
+   record.message = std::move(fields[5]);
+
+   return record;
+}
+
+void save(const fs::path& path)
+{
+   std::string json;
+
+   json += R"({"errors":[)"_sv;
+
+   bool first = true;
+
+   for (const auto& record : records) {
+      if (!std::exchange(first, false)) json += ',';
+
+      json += "\n{"_sv;
+      append_json_string("input_file"_sv, record.input_file, json);
+      json += ',';
+      append_json_string("chunk_path"_sv, record.chunk_path, json);
+      json += R"(,"offset":)"_sv;
+      json += record.offset ? std::to_string(*record.offset) : "null"s;
+      json += ',';
+      append_json_string("magic_number"_sv, record.magic_number, json);
+      json += ',';
+      append_json_string("handler"_sv, record.handler, json);
+      json += ',';
+      append_json_string("message"_sv, record.message, json);
+      json += '}';
+   }
+
+   json += "\n]}\n"_sv;
+
+   save_file_atomically(path, json);
+}
+
+void print_summary()
+{
+   if (records.empty()) return;
+
+   std::map<std::string_view, std::size_t> file_counts;
+   std::map<std::string_view, std::size_t> handler_counts;
+
+   for (const auto& record : records) {
+      ++file_counts[record.input_file];
+      ++handler_counts[record.handler];
+   }
+
+   std::string summary;
+
+   summary += std::to_string(records.size());
+   summary += " errors in "_sv;
+   summary += std::to_string(file_counts.size());
+   summary += " input files."_sv;
+
+   for (const auto& [handler, count] : handler_counts) {
+      summary += "\n   "_sv;
+      summary += handler;
+      summary += ": "_sv;
+      summary += std::to_string(count);
+   }
+
+   logger::warning(summary);
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ucfb_reader.hpp"
+
+#include <gsl/gsl>
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! \brief A failure while processing an input file.
+struct Error_record {
+   std::string input_file;
+   std::string chunk_path;
+   std::optional<std::size_t> offset;
+   std::string magic_number;
+   std::string handler;
+   std::string message;
+};
+
+//! \brief Collects Error_records from every thread for a machine readable report and a
+//! summary at exit.
+//!
+//! Chunks are located by address, so each input file's bytes must be registered with
+//! a Source_scope for errors in its chunks to get an input file, path and offset.
+namespace error_report {
+
+//! \brief Registers the bytes of an input file for the lifetime of the scope.
+class Source_scope {
+public:
+   Source_scope(std::string input_file, gsl::span<const std::byte> bytes);
+
+   ~Source_scope();
+
+   Source_scope(const Source_scope&) = delete;
+   Source_scope& operator=(const Source_scope&) = delete;
+   Source_scope(Source_scope&&) = delete;
+   Source_scope& operator=(Source_scope&&) = delete;
+
+private:
+   const std::byte* const _begin;
+};
+
+//! \brief Records a failure of a handler while processing a chunk.
+void add_chunk_error(const Ucfb_reader& chunk, std::string_view handler,
+                     std::string_view message) noexcept;
+
+//! \brief Records a failure that is not tied to a single chunk.
+void add_error(std::string input_file, std::string chunk_path, std::string_view handler,
+               std::string_view message) noexcept;
+
+void add(Error_record record) noexcept;
+
+//! \brief Gets the registered input file a chunk is from, empty if it is unknown.
+auto input_file_of(const Ucfb_reader& chunk) -> std::string;
+
+//! \brief Gets the offset of a chunk's header in its registered input file, if known.
+auto offset_of(const Ucfb_reader& chunk) -> std::optional<std::size_t>;
+
+std::size_t count() noexcept;
+
+//! \brief Gets the records added since the count was first_record.
+auto records_since(const std::size_t first_record) -> std::vector<Error_record>;
+
+//! \brief Encodes a record as a single line of text, used to pass records from worker
+//! processes to the coordinator.
+auto to_line(const Error_record& record) -> std::string;
+
+auto from_line(std::string_view line) -> Error_record;
+
+//! \brief Saves every record as a JSON document.
+void save(const std::filesystem::path& path);
+
+//! \brief Logs how many errors there were, by input file and handler.
+void print_summary();
+}
@@ -1,14 +1,25 @@
-
 #include "explode_chunk.hpp"
 #include "type_pun.hpp"
 
 #include "tbb/parallel_for.h"
 
+#include <iterator>
+#include <optional>
+#include <string>
 #include <vector>
 
+using namespace std::literals;
+
 namespace {
 
-constexpr auto index_factor = 10u;
+struct Exploded_chunk {
+   std::size_t depth;
+   Magic_number magic_number;
+   std::size_t offset;
+   std::size_t size;
+   bool parent;
+   gsl::span<const std::byte> bytes;
+};
 
 inline bool is_usable_chunk_name(const Magic_number magic_number) noexcept
 {
@@ -38,65 +49,146 @@ inline bool is_possible_child(Ucfb_reader chunk)
    return true;
 }
 
-inline std::string get_chunk_name(const Ucfb_reader& chunk, const std::size_t index)
+inline std::string format_magic_number(const Magic_number magic_number)
 {
-   std::string name;
-   name += std::to_string(index * index_factor);
-
-   name += ' ';
-
-   if (is_usable_chunk_name(chunk.magic_number())) {
-      name += view_pod_as_string(chunk.magic_number());
-   }
-   else {
-      name += serialize_magic_number(chunk.magic_number());
+   if (is_usable_chunk_name(magic_number)) {
+      return std::string{view_pod_as_string(magic_number)};
    }
 
-   return name;
+   return serialize_magic_number(magic_number);
 }
 
-void write_child_chunks(const std::vector<Ucfb_reader>& children, File_saver& file_saver)
+auto find_children(Ucfb_reader chunk, Chunk_classifier& classifier)
+   -> std::optional<std::vector<Ucfb_reader>>
 {
-   tbb::parallel_for(std::size_t{0u}, children.size(),
-                     [&](auto i) { explode_chunk(children[i], file_saver, i); });
+   if (!is_possible_parent(chunk)) return std::nullopt;
+
+   if (!classifier.should_scan(chunk.magic_number(), chunk.size())) return std::nullopt;
+
+   std::vector<Ucfb_reader> children;
+   children.reserve(32);
+
+   while (chunk) {
+      const auto child = chunk.read_child(std::nothrow);
+
+      if (!child || !is_possible_child(*child)) {
+         classifier.record_scan(chunk.magic_number(), chunk.size(), false);
+
+         return std::nullopt;
+      }
+
+      children.emplace_back(*child);
+   }
+
+   classifier.record_scan(chunk.magic_number(), chunk.size(), !children.empty());
+
+   return children;
 }
 
-void write_data_chunk(Ucfb_reader chunk, File_saver& file_saver, const std::size_t index)
+// Appends a chunk and all the chunks below it, in the order they appear in the file.
+void explode_tree(const Ucfb_reader& chunk, const std::size_t depth,
+                  const std::byte* const file_begin, Chunk_classifier& classifier,
+                  std::vector<Exploded_chunk>& exploded)
 {
-   const auto name = get_chunk_name(chunk, index);
+   // Offsets are of the chunk's header, so they line up with a hex editor.
+   const auto offset = static_cast<std::size_t>(chunk.bytes().data() - file_begin) - 8;
 
-   const auto data = chunk.read_array_unaligned<char>(chunk.size());
+   const auto children = find_children(chunk, classifier);
 
-   std::string buffer;
-   buffer.reserve(data.size());
-   buffer.append(data.data(), data.size());
+   if (!children) {
+      exploded.push_back(
+         {depth, chunk.magic_number(), offset, chunk.size(), false, chunk.bytes()});
 
-   file_saver.save_file(buffer, "", name, ".chunk");
-}
+      return;
+   }
+
+   exploded.push_back(
+      {depth, chunk.magic_number(), offset, chunk.size(), true, chunk.bytes()});
+
+   std::vector<std::vector<Exploded_chunk>> exploded_children(children->size());
+
+   tbb::parallel_for(std::size_t{0u}, children->size(), [&](const std::size_t i) {
+      explode_tree((*children)[i], depth + 1, file_begin, classifier,
+                   exploded_children[i]);
+   });
+
+   for (auto& child : exploded_children) {
+      exploded.insert(exploded.end(), std::make_move_iterator(child.begin()),
+                      std::make_move_iterator(child.end()));
+   }
 }
 
-void explode_chunk(Ucfb_reader chunk, File_saver& file_saver, const std::size_t index)
+// Data files are named after the chunk's offset in the file and its magic number, so a
+// chunk keeps its file name when chunks are added or removed before it. Data chunks
+// never hold each other so every one has a file of its own.
+auto data_file_name(const Exploded_chunk& chunk) -> std::string
 {
-   if (!is_possible_parent(chunk)) return write_data_chunk(chunk, file_saver, index);
+   auto name = std::to_string(chunk.offset);
 
-   std::vector<Ucfb_reader> children;
-   children.reserve(32);
+   if (name.size() < 10) name.insert(0, 10 - name.size(), '0');
 
-   while (chunk) {
-      const auto child = chunk.read_child(std::nothrow);
+   name += '_';
+   name += format_magic_number(chunk.magic_number);
 
-      if (!child || !is_possible_child(*child)) {
-         chunk.reset_head();
+   return name;
+}
 
-         return write_data_chunk(chunk, file_saver, index);
+auto create_manifest(const std::vector<Exploded_chunk>& exploded) -> std::string
+{
+   std::string manifest;
+   manifest.reserve(exploded.size() * 48);
+
+   manifest += explode_manifest_header;
+   manifest += '\n';
+
+   for (const auto& chunk : exploded) {
+      manifest += chunk.parent ? "parent "_sv : "data "_sv;
+      manifest += std::to_string(chunk.depth);
+      manifest += ' ';
+      manifest += format_magic_number(chunk.magic_number);
+      manifest += ' ';
+      manifest += std::to_string(chunk.offset);
+      manifest += ' ';
+      manifest += std::to_string(chunk.size);
+
+      if (!chunk.parent) {
+         manifest += ' ';
+         manifest += explode_data_directory;
+         manifest += '/';
+         manifest += data_file_name(chunk);
+         manifest += explode_data_extension;
       }
 
-      children.emplace_back(*child);
+      manifest += '\n';
    }
 
-   const auto name = get_chunk_name(chunk, index);
+   return manifest;
+}
+
+void save_data_chunks(const std::vector<Exploded_chunk>& exploded, File_saver& file_saver)
+{
+   tbb::parallel_for(std::size_t{0u}, exploded.size(), [&](const std::size_t i) {
+      const auto& chunk = exploded[i];
+
+      if (chunk.parent) return;
+
+      file_saver.save_file({reinterpret_cast<const char*>(chunk.bytes.data()),
+                            static_cast<std::size_t>(chunk.bytes.size())},
+                           explode_data_directory, data_file_name(chunk),
+                           explode_data_extension);
+   });
+}
+}
+
+void explode_chunk(Ucfb_reader root, File_saver& file_saver, Chunk_classifier& classifier)
+{
+   std::vector<Exploded_chunk> exploded;
+   exploded.reserve(1024);
+
+   explode_tree(root, 0, root.bytes().data() - 8, classifier, exploded);
 
-   auto nested_saver = file_saver.create_nested(name);
+   save_data_chunks(exploded, file_saver);
 
-   write_child_chunks(children, nested_saver);
-}
\ No newline at end of file
+   file_saver.save_file(create_manifest(exploded), ""_sv, explode_manifest_name,
+                        explode_manifest_extension);
+}
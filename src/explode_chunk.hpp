@@ -1,9 +1,28 @@
 #pragma once
 
+#include "chunk_classifier.hpp"
 #include "file_saver.hpp"
+#include "string_helpers.hpp"
 #include "ucfb_reader.hpp"
 
 #include <cstddef>
 
-void explode_chunk(Ucfb_reader chunk, File_saver& file_saver,
-                   const std::size_t index = 0);
\ No newline at end of file
+constexpr auto explode_manifest_header = "swbf-unmunge-explode 2"_sv;
+constexpr auto explode_manifest_name = "explode"_sv;
+constexpr auto explode_manifest_extension = ".manifest"_sv;
+constexpr auto explode_data_directory = "data"_sv;
+constexpr auto explode_data_extension = ".chunk"_sv;
+
+//! \brief Explodes a chunk and all the chunks below it.
+//!
+//! A manifest is saved listing every chunk in the order they appear in the file, with
+//! its depth, magic number, offset, size and, for chunks holding data, the file holding
+//! its contents. Every data chunk gets its own file in the data directory, named after
+//! its offset in the file and its magic number, so it can be edited without touching
+//! any other chunk. Parent chunks get no files or directories of their own.
+//!
+//! \param root The chunk to explode, usually the root chunk of a file.
+//! \param file_saver The File_saver to save the manifest and data chunks with.
+//! \param classifier The Chunk_classifier deciding which chunks to scan for children.
+void explode_chunk(Ucfb_reader root, File_saver& file_saver,
+                   Chunk_classifier& classifier);
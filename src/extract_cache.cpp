@@ -0,0 +1,155 @@
+#include "extract_cache.hpp"
+#include "content_hash.hpp"
+#include "file_saver.hpp"
+#include "string_helpers.hpp"
+#include "type_pun.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+using namespace std::literals;
+
+namespace {
+
+// Bump this whenever a change to a handler alters the files it outputs.
+constexpr std::uint32_t cache_version = 2;
+
+constexpr auto cache_header = "swbf-unmunge-cache"_sv;
+
+std::uint64_t options_seed(const App_options& options,
+                           const Input_format input_format) noexcept
+{
+   std::string string;
+
+   string += view_pod_as_string(cache_version);
+   string += view_pod_as_string(input_format.platform);
+   string += view_pod_as_string(input_format.game_version);
+   string += view_pod_as_string(options.output_game_version());
+   string += view_pod_as_string(options.image_save_format());
+
+   return content_hash(string);
+}
+
+fs::path cache_file_path(const fs::path& cache_directory, const fs::path& input_file)
+{
+   const auto absolute_input = fs::absolute(input_file).u8string();
+
+   auto file_name = input_file.stem().u8string();
+   file_name += '_';
+   file_name += content_hash_string(content_hash(absolute_input));
+   file_name += ".cache"_sv;
+
+   return cache_directory / fs::u8path(file_name);
+}
+}
+
+Extract_cache::Extract_cache(const fs::path& cache_directory, const fs::path& input_file,
+                             const App_options& options, const Input_format input_format)
+   : _cache_file{cache_file_path(cache_directory, input_file)},
+     _seed{options_seed(options, input_format)}
+{
+   fs::create_directories(cache_directory);
+
+   load();
+}
+
+std::uint64_t Extract_cache::chunk_key(const Ucfb_reader& chunk) const noexcept
+{
+   return content_hash(chunk.bytes(),
+                       _seed ^ static_cast<std::uint32_t>(chunk.magic_number()));
+}
+
+std::uint64_t Extract_cache::combine_keys(const std::vector<std::uint64_t>& keys) const
+   noexcept
+{
+   return content_hash(gsl::as_bytes(gsl::span<const std::uint64_t>{keys}), _seed);
+}
+
+bool Extract_cache::up_to_date(const std::uint64_t key)
+{
+   const auto entry = _previous.find(key);
+
+   if (entry == std::cend(_previous)) return false;
+
+   const auto& output_files = entry->second;
+
+   const bool outputs_exist =
+      std::all_of(std::cbegin(output_files), std::cend(output_files),
+                  [](const std::string& file) { return fs::exists(fs::u8path(file)); });
+
+   if (!outputs_exist) return false;
+
+   _current.emplace(key, output_files);
+
+   return true;
+}
+
+void Extract_cache::store(const std::uint64_t key, std::vector<std::string> output_files)
+{
+   _current.emplace(key, std::move(output_files));
+}
+
+void Extract_cache::save() const
+{
+   std::string buffer;
+   buffer.reserve(_current.size() * 128);
+
+   buffer += cache_header;
+   buffer += ' ';
+   buffer += std::to_string(cache_version);
+   buffer += '\n';
+
+   for (const auto& entry : _current) {
+      buffer += content_hash_string(entry.first);
+      buffer += ' ';
+      buffer += std::to_string(entry.second.size());
+      buffer += '\n';
+
+      for (const auto& file : entry.second) {
+         buffer += file;
+         buffer += '\n';
+      }
+   }
+
+   save_file_atomically(_cache_file, buffer);
+}
+
+void Extract_cache::load()
+{
+   std::ifstream file{_cache_file, std::ios::binary};
+
+   if (!file) return;
+
+   std::string line;
+   std::getline(file, line);
+
+   if (line != std::string{cache_header} + ' ' + std::to_string(cache_version)) return;
+
+   // A damaged cache is treated as an empty one, everything is simply extracted again.
+   try {
+      while (std::getline(file, line)) {
+         const auto [key_string, count_string] = split_string(line, ' ');
+
+         if (key_string.length() != 16) throw std::runtime_error{"Bad cache entry."};
+
+         const auto key = std::stoull(std::string{key_string}, nullptr, 16);
+         const auto count = std::stoull(std::string{count_string});
+
+         std::vector<std::string> output_files;
+         output_files.reserve(count);
+
+         for (std::size_t i = 0; i < count && std::getline(file, line); ++i) {
+            output_files.emplace_back(std::move(line));
+         }
+
+         if (output_files.size() != count) throw std::runtime_error{"Bad cache entry."};
+
+         _previous.emplace(key, std::move(output_files));
+      }
+   }
+   catch (const std::exception&) {
+      _previous.clear();
+   }
+}
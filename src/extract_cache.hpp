@@ -0,0 +1,48 @@
+#pragma once
+
+#include "app_options.hpp"
+#include "ucfb_reader.hpp"
+
+#include "tbb/concurrent_unordered_map.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! \brief Persistent record of the output files each chunk of an input file produced.
+//!
+//! Chunks are keyed by a hash of their contents, seeded with the cache version and the
+//! options that affect output. On the next extraction a chunk whose key is present and
+//! whose outputs all still exist can be skipped.
+//!
+//! Only entries that are looked up or stored during a run are kept when the cache is
+//! saved, so entries for chunks that changed or were removed are dropped.
+//!
+//! up_to_date and store are threadsafe, save is not.
+class Extract_cache {
+public:
+   Extract_cache(const std::filesystem::path& cache_directory,
+                 const std::filesystem::path& input_file, const App_options& options,
+                 const Input_format input_format);
+
+   std::uint64_t chunk_key(const Ucfb_reader& chunk) const noexcept;
+
+   std::uint64_t combine_keys(const std::vector<std::uint64_t>& keys) const noexcept;
+
+   bool up_to_date(const std::uint64_t key);
+
+   void store(const std::uint64_t key, std::vector<std::string> output_files);
+
+   void save() const;
+
+private:
+   void load();
+
+   const std::filesystem::path _cache_file;
+   const std::uint64_t _seed;
+
+   std::unordered_map<std::uint64_t, std::vector<std::string>> _previous;
+   tbb::concurrent_unordered_map<std::uint64_t, std::vector<std::string>> _current;
+};
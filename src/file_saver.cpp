@@ -1,26 +1,40 @@
 #include "file_saver.hpp"
-#include "synced_cout.hpp"
+#include "content_hash.hpp"
+#include "logger.hpp"
+#include "string_helpers.hpp"
 
 #include <gsl/gsl>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <fstream>
 #include <limits>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
+#include <system_error>
 
 namespace fs = std::filesystem;
 using namespace std::literals;
 
 File_saver::File_saver(const fs::path& path, bool verbose) noexcept
-   : _path{path.string()}, _verbose{verbose}
+   : File_saver{path, verbose, false, std::make_shared<Outputs>()}
 {
-   fs::create_directory(_path);
+}
+
+File_saver::File_saver(const fs::path& path, bool verbose, bool discard,
+                       std::shared_ptr<Outputs> outputs) noexcept
+   : _path{path.string()},
+     _verbose{verbose},
+     _discard{discard},
+     _outputs{std::move(outputs)}
+{
+   if (!_discard) fs::create_directory(_path);
 }
 
 File_saver::File_saver(File_saver&& other) noexcept
-   : File_saver{other._path, other._verbose}
+   : File_saver{other._path, other._verbose, other._discard, other._outputs}
 {
    std::lock_guard<tbb::spin_rw_mutex> lock{other._dirs_mutex};
    std::swap(_created_dirs, other._created_dirs);
@@ -31,18 +45,51 @@ void File_saver::save_file(std::string_view contents, std::string_view directory
 {
    const auto path = get_file_path(directory, name, extension);
 
+   if (_discard) {
+      _outputs->checksums.push_back({path, content_hash(contents)});
+
+      return;
+   }
+
    if (_verbose) {
-      synced_cout::print("Info: Saving file \""s, path, '\"', '\n');
+      logger::info("Saving file \""s, path, '\"');
    }
 
-   std::ofstream file{path, std::ios::binary};
-   file.write(contents.data(), contents.size());
+   save_file_atomically(fs::u8path(path), contents);
+}
+
+void File_saver::save_file_blocks(
+   std::string_view directory, std::string_view name, std::string_view extension,
+   const std::function<void(const Block_sink&)>& write_blocks)
+{
+   const auto path = get_file_path(directory, name, extension);
+
+   // The checksum is of the whole file, so when discarding the blocks are gathered.
+   if (_discard) {
+      std::string contents;
+
+      write_blocks([&contents](std::string_view block) { contents += block; });
+
+      _outputs->checksums.push_back({path, content_hash(contents)});
+
+      return;
+   }
+
+   if (_verbose) {
+      logger::info("Saving file \""s, path, '\"');
+   }
+
+   write_file_atomically(fs::u8path(path), [&write_blocks](std::ofstream& file) {
+      write_blocks([&file](std::string_view block) {
+         file.write(block.data(), block.size());
+      });
+   });
 }
 
 std::string File_saver::get_file_path(std::string_view directory, std::string_view name,
                                       std::string_view extension)
 {
-   create_dir(directory);
+   if (!_discard) create_dir(directory);
 
    std::string path;
    path.reserve(_path.length() + 1 + directory.length() + 1 + name.length() +
@@ -61,6 +108,8 @@ std::string File_saver::get_file_path(std::string_view directory, std::string_vi
    path += name;
    path += extension;
 
+   _outputs->files.push_back(path);
+
    return path;
 }
 
@@ -96,5 +145,92 @@ File_saver File_saver::create_nested(std::string_view directory) const
    new_path.append(std::cbegin(directory), std::cend(directory));
    new_path += fs::path::preferred_separator;
 
-   return {new_path, _verbose};
+   return {new_path, _verbose, _discard, _outputs};
+}
+
+File_saver File_saver::create_sibling() const
+{
+   return {_path, _verbose, _discard, std::make_shared<Outputs>()};
+}
+
+File_saver File_saver::create_discarding(const fs::path& path, bool verbose) noexcept
+{
+   return {path, verbose, true, std::make_shared<Outputs>()};
+}
+
+auto File_saver::output_files() const -> std::vector<std::string>
+{
+   return {std::cbegin(_outputs->files), std::cend(_outputs->files)};
+}
+
+auto File_saver::output_checksums() const -> std::vector<Output_checksum>
+{
+   return {std::cbegin(_outputs->checksums), std::cend(_outputs->checksums)};
+}
+
+bool File_saver::discards_output() const noexcept
+{
+   return _discard;
+}
+
+bool File_saver::verbose() const noexcept
+{
+   return _verbose;
+}
+
+void File_saver::mark_incomplete() noexcept
+{
+   _outputs->complete = false;
+}
+
+bool File_saver::complete() const noexcept
+{
+   return _outputs->complete;
+}
+
+void write_file_atomically(const fs::path& path,
+                           const std::function<void(std::ofstream& file)>& write)
+{
+   const auto temp_path = temporary_file_path(path);
+
+   try {
+      {
+         std::ofstream file{temp_path, std::ios::binary};
+
+         write(file);
+
+         if (!file) {
+            throw std::runtime_error{"Failed to write file: "s += path.u8string()};
+         }
+      }
+
+      fs::rename(temp_path, path);
+   }
+   catch (...) {
+      std::error_code error;
+      fs::remove(temp_path, error);
+
+      throw;
+   }
+}
+
+void save_file_atomically(const fs::path& path, std::string_view contents)
+{
+   write_file_atomically(path, [contents](std::ofstream& file) {
+      file.write(contents.data(), contents.size());
+   });
+}
+
+auto temporary_file_path(const fs::path& path) -> fs::path
+{
+   // Several chunks can save to the same path at once, each writer gets a temporary file
+   // of its own so they never write into the same one.
+   static std::atomic<std::uint64_t> next_id{0};
+
+   auto temp_path = path;
+   temp_path += '.';
+   temp_path += std::to_string(next_id++);
+   temp_path += ".partial"_sv;
+
+   return temp_path;
 }
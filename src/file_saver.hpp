@@ -1,32 +1,100 @@
 #pragma once
 
+#include "tbb/concurrent_vector.h"
 #include "tbb/spin_rw_mutex.h"
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
+struct Output_checksum {
+   std::string file;
+   std::uint64_t checksum;
+};
+
 class File_saver {
 public:
+   using Block_sink = std::function<void(std::string_view block)>;
+
    File_saver(const std::filesystem::path& path, bool verbose = false) noexcept;
 
+   // Creates a saver that writes nothing, it only records a checksum of each file it
+   // would have saved. Used to verify input files.
+   static File_saver create_discarding(const std::filesystem::path& path,
+                                       bool verbose = false) noexcept;
+
    File_saver(File_saver&& other) noexcept;
 
    void save_file(std::string_view contents, std::string_view directory,
                   std::string_view name, std::string_view extension);
 
+   // Saves a file that is produced in blocks so it never has to be held in memory whole.
+   // write_blocks is called once with a sink that appends each block to the file.
+   void save_file_blocks(std::string_view directory, std::string_view name,
+                         std::string_view extension,
+                         const std::function<void(const Block_sink&)>& write_blocks);
+
    std::string get_file_path(std::string_view directory, std::string_view name,
                              std::string_view extension);
 
+   // Creates a saver for a subdirectory. Its output files and completeness are shared
+   // with this saver, so files saved through it show up in this saver's output_files()
+   // and marking it incomplete marks this saver incomplete too.
    File_saver create_nested(std::string_view directory) const;
 
+   // Creates a saver for the same directory that tracks its own output files.
+   File_saver create_sibling() const;
+
+   auto output_files() const -> std::vector<std::string>;
+
+   auto output_checksums() const -> std::vector<Output_checksum>;
+
+   bool discards_output() const noexcept;
+
+   bool verbose() const noexcept;
+
+   // Marks the outputs of this saver, and of every saver nested with it, as incomplete.
+   // Used when a handler fails partway.
+   void mark_incomplete() noexcept;
+
+   bool complete() const noexcept;
+
 private:
+   struct Outputs {
+      tbb::concurrent_vector<std::string> files;
+      tbb::concurrent_vector<Output_checksum> checksums;
+      std::atomic_bool complete{true};
+   };
+
+   File_saver(const std::filesystem::path& path, bool verbose, bool discard,
+              std::shared_ptr<Outputs> outputs) noexcept;
+
    void create_dir(std::string_view directory) noexcept;
 
    const std::string _path;
    const bool _verbose = false;
+   const bool _discard = false;
 
    tbb::spin_rw_mutex _dirs_mutex;
    std::vector<std::string> _created_dirs;
+
+   std::shared_ptr<Outputs> _outputs;
 };
+
+// Writes a file under a temporary name and then renames it into place, so that an
+// interrupted write never leaves a truncated file behind under the real name. The
+// temporary file is removed if write throws.
+void write_file_atomically(const std::filesystem::path& path,
+                           const std::function<void(std::ofstream& file)>& write);
+
+// Writes a file with the given contents through write_file_atomically.
+void save_file_atomically(const std::filesystem::path& path, std::string_view contents);
+
+// Gets a temporary path to write a file under before renaming it into place. Every call
+// returns a different path.
+auto temporary_file_path(const std::filesystem::path& path) -> std::filesystem::path;
@@ -0,0 +1,432 @@
+#include "chunk_handlers.hpp"
+#include "file_saver.hpp"
+#include "logger.hpp"
+#include "magic_number.hpp"
+#include "string_helpers.hpp"
+#include "ucfb_writer.hpp"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include "tbb/parallel_for.h"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+// Animation banks hold their keyframes as quantised curves, one per component of a
+// bone's rotation and translation. A curve starts with an absolute 16 bit value and
+// continues with 8 bit deltas and control codes until it has a value for every frame.
+
+constexpr std::int8_t curve_hold = 0;
+constexpr std::int8_t curve_reset = -0x7f;
+constexpr std::int8_t curve_hold_many = -0x80;
+
+constexpr float rotation_multiplier = 1.0f / 2047.0f;
+
+// Exported animations are sampled at 30fps, like models.
+constexpr float frame_rate = 29.97003f;
+
+constexpr std::size_t rotation_curves = 4;
+constexpr std::size_t translation_curves = 3;
+constexpr std::size_t curves_per_bone = rotation_curves + translation_curves;
+
+struct Mina_entry {
+   std::array<std::uint32_t, 2> unknown;
+   std::uint32_t name_hash;
+   std::uint16_t frame_count;
+   std::uint16_t bone_count;
+};
+
+static_assert(std::is_pod_v<Mina_entry>);
+static_assert(sizeof(Mina_entry) == 16);
+
+struct Tnja_entry {
+   std::uint32_t bone_hash;
+   std::array<std::uint32_t, rotation_curves> rotation_offsets;
+   std::array<std::uint32_t, translation_curves> translation_offsets;
+   std::array<float, translation_curves> translation_bias;
+   float translation_multiplier;
+};
+
+static_assert(std::is_pod_v<Tnja_entry>);
+static_assert(sizeof(Tnja_entry) == 48);
+
+struct Animation_info {
+   std::uint32_t name_hash;
+   std::uint16_t frame_count;
+   gsl::span<const Tnja_entry> bones;
+};
+
+struct Bone_keyframes {
+   std::uint32_t bone_hash;
+   std::vector<glm::quat> rotations;
+   std::vector<glm::vec3> translations;
+};
+
+struct Animation {
+   std::uint32_t name_hash;
+   std::uint16_t frame_count;
+   std::vector<Bone_keyframes> bones;
+};
+
+class Curve_reader {
+public:
+   Curve_reader(gsl::span<const std::byte> data, const std::size_t offset)
+      : _data{data}, _head{offset}
+   {
+   }
+
+   template<typename Type>
+   Type read()
+   {
+      static_assert(std::is_trivially_copyable_v<Type>);
+
+      if (_head + sizeof(Type) > static_cast<std::size_t>(_data.size())) {
+         throw std::runtime_error{"Animation curve runs past the end of its data."};
+      }
+
+      Type value;
+      std::memcpy(&value, _data.data() + _head, sizeof(Type));
+
+      _head += sizeof(Type);
+
+      return value;
+   }
+
+private:
+   const gsl::span<const std::byte> _data;
+   std::size_t _head;
+};
+
+// Decodes a curve into its quantised value at every frame.
+void decode_curve(gsl::span<const std::byte> data, const std::size_t offset,
+                  gsl::span<std::int32_t> values)
+{
+   Curve_reader reader{data, offset};
+
+   const auto frame_count = static_cast<std::size_t>(values.size());
+   std::size_t frame = 0;
+
+   while (frame < frame_count) {
+      std::int32_t value = reader.read<std::int16_t>();
+      values[frame++] = value;
+
+      while (frame < frame_count) {
+         const auto control = reader.read<std::int8_t>();
+
+         if (control == curve_hold) {
+            values[frame++] = value;
+         }
+         else if (control == curve_reset) {
+            break;
+         }
+         else if (control == curve_hold_many) {
+            const std::size_t count = reader.read<std::uint8_t>();
+
+            for (std::size_t i = 0; i < count && frame < frame_count; ++i) {
+               values[frame++] = value;
+            }
+         }
+         else {
+            value += control;
+            values[frame++] = value;
+         }
+      }
+   }
+}
+
+// Turns quantised values into floats. Kept as a plain loop over raw pointers, indexing
+// the spans would bounds check every element and stop the loop being vectorised.
+void dequantise(gsl::span<const std::int32_t> values, const float bias,
+                const float multiplier, gsl::span<float> out) noexcept
+{
+   Expects(out.size() >= values.size());
+
+   const auto count = static_cast<std::size_t>(values.size());
+   const std::int32_t* const in_data = values.data();
+   float* const out_data = out.data();
+
+   for (std::size_t i = 0; i < count; ++i) {
+      out_data[i] = bias + multiplier * static_cast<float>(in_data[i]);
+   }
+}
+
+auto decode_bone(const Tnja_entry& bone, const std::size_t frame_count,
+                 gsl::span<const std::byte> data) -> Bone_keyframes
+{
+   std::vector<std::int32_t> quantised(curves_per_bone * frame_count);
+   std::vector<float> components(curves_per_bone * frame_count);
+
+   const auto curve = [frame_count](auto& vector, const std::size_t index) {
+      using Element = typename std::remove_reference_t<decltype(vector)>::value_type;
+
+      return gsl::span<Element>{vector.data() + index * frame_count,
+                                static_cast<std::ptrdiff_t>(frame_count)};
+   };
+
+   for (std::size_t i = 0; i < rotation_curves; ++i) {
+      decode_curve(data, bone.rotation_offsets[i], curve(quantised, i));
+   }
+
+   for (std::size_t i = 0; i < translation_curves; ++i) {
+      decode_curve(data, bone.translation_offsets[i],
+                   curve(quantised, rotation_curves + i));
+   }
+
+   const auto rotations_size = static_cast<std::ptrdiff_t>(rotation_curves * frame_count);
+
+   dequantise({quantised.data(), rotations_size}, 0.0f, rotation_multiplier,
+              {components.data(), rotations_size});
+
+   for (std::size_t i = 0; i < translation_curves; ++i) {
+      const auto index = rotation_curves + i;
+
+      dequantise(curve(quantised, index), bone.translation_bias[i],
+                 bone.translation_multiplier, curve(components, index));
+   }
+
+   Bone_keyframes keyframes;
+   keyframes.bone_hash = bone.bone_hash;
+   keyframes.rotations.reserve(frame_count);
+   keyframes.translations.reserve(frame_count);
+
+   for (std::size_t frame = 0; frame < frame_count; ++frame) {
+      const auto component = [&](const std::size_t index) {
+         return components[index * frame_count + frame];
+      };
+
+      keyframes.rotations.push_back(glm::normalize(
+         glm::quat{component(3), component(0), component(1), component(2)}));
+      keyframes.translations.emplace_back(component(4), component(5), component(6));
+   }
+
+   return keyframes;
+}
+
+auto read_animation_infos(Ucfb_reader_strict<"SMNA"_mn>& smna)
+   -> std::vector<Animation_info>
+{
+   smna.consume(8);
+
+   const auto animation_count = smna.read_trivial_unaligned<std::uint16_t>();
+   smna.consume(2);
+
+   const auto mina_entries =
+      smna.read_child_strict<"MINA"_mn>().read_array<Mina_entry>(animation_count);
+
+   auto tnja = smna.read_child_strict<"TNJA"_mn>();
+
+   std::vector<Animation_info> infos;
+   infos.reserve(animation_count);
+
+   for (const auto& entry : mina_entries) {
+      infos.push_back({entry.name_hash, entry.frame_count,
+                       tnja.read_array<Tnja_entry>(entry.bone_count)});
+   }
+
+   return infos;
+}
+
+auto decode_animations(Ucfb_reader bin) -> std::vector<Animation>
+{
+   bin.consume(8);
+
+   auto smna = bin.read_child_strict<"SMNA"_mn>();
+
+   const auto infos = read_animation_infos(smna);
+
+   auto tada = smna.read_child_strict<"TADA"_mn>();
+
+   const auto data = tada.read_array<std::byte>(tada.size());
+
+   std::vector<Animation> animations(infos.size());
+
+   tbb::parallel_for(std::size_t{0}, infos.size(), [&](const std::size_t i) {
+      const auto& info = infos[i];
+      auto& animation = animations[i];
+
+      animation.name_hash = info.name_hash;
+      animation.frame_count = info.frame_count;
+      animation.bones.resize(static_cast<std::size_t>(info.bones.size()));
+
+      tbb::parallel_for(std::size_t{0}, animation.bones.size(), [&](const auto bone) {
+         const auto& bone_info = info.bones[static_cast<std::ptrdiff_t>(bone)];
+
+         animation.bones[bone] = decode_bone(bone_info, info.frame_count, data);
+      });
+   });
+
+   return animations;
+}
+
+std::string get_animation_name(std::string_view bank_name, const Animation& animation)
+{
+   std::array<char, 16> hash;
+   std::snprintf(hash.data(), hash.size(), "%08x", animation.name_hash);
+
+   std::string name{bank_name};
+   name += '_';
+   name += hash.data();
+
+   return name;
+}
+
+std::string create_animation_msh(const Animation& animation, std::string_view name)
+{
+   constexpr std::size_t cycl_name_size = 64;
+   constexpr std::size_t frame_size = 20;
+
+   const auto last_frame =
+      static_cast<std::uint32_t>(std::max(animation.frame_count, std::uint16_t{1}) - 1);
+
+   Ucfb_writer writer{1024 + animation.bones.size() * animation.frame_count *
+                                2 * frame_size};
+
+   writer.open("HEDR"_mn);
+   writer.open("MSH2"_mn);
+   writer.open("SINF"_mn);
+
+   writer.open("NAME"_mn);
+   writer.write(name);
+   writer.close();
+
+   writer.open("FRAM"_mn);
+   writer.write_multiple(std::int32_t{0}, static_cast<std::int32_t>(last_frame),
+                         frame_rate);
+   writer.close();
+
+   writer.close();
+   writer.close();
+
+   writer.open("ANM2"_mn);
+
+   writer.open("CYCL"_mn);
+   writer.write(std::uint32_t{1});
+   writer.write(name.substr(0, cycl_name_size - 1), false, false);
+   writer.write(std::string(cycl_name_size - std::min(name.size(), cycl_name_size - 1),
+                            '\0'),
+                false, false);
+   writer.write_multiple(frame_rate, std::uint32_t{0}, std::uint32_t{0}, last_frame);
+   writer.close();
+
+   writer.open("KFR3"_mn);
+   writer.write(static_cast<std::uint32_t>(animation.bones.size()));
+
+   for (const auto& bone : animation.bones) {
+      writer.write_multiple(bone.bone_hash, std::uint32_t{0},
+                            static_cast<std::uint32_t>(bone.translations.size()),
+                            static_cast<std::uint32_t>(bone.rotations.size()));
+
+      for (std::uint32_t frame = 0; frame < bone.translations.size(); ++frame) {
+         const auto& translation = bone.translations[frame];
+
+         writer.write_multiple(frame, translation.x, translation.y, translation.z);
+      }
+
+      for (std::uint32_t frame = 0; frame < bone.rotations.size(); ++frame) {
+         const auto& rotation = bone.rotations[frame];
+
+         writer.write_multiple(frame, rotation.x, rotation.y, rotation.z, rotation.w);
+      }
+   }
+
+   writer.close();
+   writer.close();
+
+   writer.write_empty("CL1L"_mn);
+
+   writer.close();
+
+   return writer.finish();
+}
+
+// Decodes the first BIN_ child of a bank and saves each of its animations as a msh.
+void save_animations(Ucfb_reader bank, std::string_view name, File_saver& file_saver)
+{
+   while (bank) {
+      const auto child = bank.read_child();
+
+      if (child.magic_number() != "BIN_"_mn) continue;
+
+      const auto start = std::chrono::steady_clock::now();
+
+      const auto animations = decode_animations(child);
+
+      if (file_saver.verbose()) {
+         const std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - start;
+
+         std::size_t keyframes = 0;
+
+         for (const auto& animation : animations) {
+            keyframes += animation.bones.size() * animation.frame_count;
+         }
+
+         logger::info("Decoded "_sv, animations.size(), " animations from "_sv, name,
+                      " in "_sv, time.count() * 1000.0, "ms ("_sv,
+                      time.count() > 0.0 ? keyframes / time.count() : 0.0,
+                      " bone keyframes/s)"_sv);
+      }
+
+      tbb::parallel_for(std::size_t{0}, animations.size(), [&](const std::size_t i) {
+         const auto animation_name = get_animation_name(name, animations[i]);
+
+         file_saver.save_file(create_animation_msh(animations[i], animation_name),
+                              "anims"_sv, animation_name, ".msh"_sv);
+      });
+
+      return;
+   }
+}
+
+// Saves the raw bank and then the animations decoded from it, returning the bank's name.
+// zafbin banks are munged by the same tool as zaabin banks and are decoded the same way.
+// A bank that fails to decode still has its raw dump saved.
+auto handle_animation_bank(Ucfb_reader bank, File_saver& file_saver,
+                           std::string_view extension) -> std::string
+{
+   const auto name = bank.read_child_strict<"NAME"_mn>().read_string();
+
+   auto contents = bank;
+
+   bank.reset_head();
+
+   handle_unknown(bank, file_saver, name, extension);
+
+   try {
+      save_animations(contents, name, file_saver);
+   }
+   catch (const std::exception& e) {
+      logger::warning("Unable to decode animations, saving the bank as is.\n   Bank: "s,
+                      name, extension, "\n   Message: "s, e.what());
+   }
+
+   return std::string{name};
+}
+}
+
+void handle_zaabin(Ucfb_reader zaabin, File_saver& file_saver)
+{
+   const auto name = handle_animation_bank(zaabin, file_saver, ".zaabin"_sv);
+
+   file_saver.save_file("ucft\n{\n}"_sv, "munged"_sv, name, ".anims");
+}
+
+void handle_zafbin(Ucfb_reader zafbin, File_saver& file_saver)
+{
+   handle_animation_bank(zafbin, file_saver, ".zafbin"_sv);
+}
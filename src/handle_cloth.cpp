@@ -175,12 +175,14 @@ auto read_cloth_collision(Ucfb_reader_strict<"COLL"_mn> collision)
 
 void handle_cloth(Ucfb_reader cloth, msh::Builders_map& builders)
 {
-   const std::string model_name{cloth.read_child_strict<"INFO"_mn>().read_string()};
+   const auto model_name = cloth.read_child_strict<"INFO"_mn>().read_string();
+
+   auto builder = builders[model_name];
 
    msh::Cloth cloth_msh{};
 
-   cloth_msh.name = cloth.read_child_strict<"NAME"_mn>().read_string();
-   cloth_msh.parent = cloth.read_child_strict<"PRNT"_mn>().read_string();
+   cloth_msh.name = builder.intern(cloth.read_child_strict<"NAME"_mn>().read_string());
+   cloth_msh.parent = builder.intern(cloth.read_child_strict<"PRNT"_mn>().read_string());
 
    const auto xframe = cloth.read_child_strict<"XFRM"_mn>();
    std::tie(cloth_msh.rotation, cloth_msh.position) = read_xframe(xframe);
@@ -189,6 +191,5 @@ void handle_cloth(Ucfb_reader cloth, msh::Builders_map& builders)
 
    cloth_msh.collision = read_cloth_collision(cloth.read_child_strict<"COLL"_mn>());
 
-   auto& builder = builders[model_name];
    builder.add_cloth(std::move(cloth_msh));
 }
@@ -57,7 +57,7 @@ void handle_tree(Ucfb_reader_strict<"TREE"_mn> tree, msh::Collsion_mesh& collisi
 
 void handle_collision(Ucfb_reader collision, msh::Builders_map& builders)
 {
-   const std::string name{collision.read_child_strict<"NAME"_mn>().read_string()};
+   const auto name = collision.read_child_strict<"NAME"_mn>().read_string();
 
    auto mask = collision.read_child_strict_optional<"MASK"_mn>();
 
@@ -1,4 +1,5 @@
 #include "chunk_processor.hpp"
+#include "error_report.hpp"
 
 #include "tbb/parallel_for_each.h"
 
@@ -6,7 +7,7 @@
 #include <vector>
 
 void handle_lvl_child(Ucfb_reader lvl_child, const App_options& app_options,
-                      File_saver& file_saver)
+                      const Input_format input_format, File_saver& file_saver)
 {
    lvl_child.consume(4); // lvl name hash
    lvl_child.consume(4); // lvl size left
@@ -18,13 +19,14 @@ void handle_lvl_child(Ucfb_reader lvl_child, const App_options& app_options,
 
    msh::Builders_map msh_builders;
 
-   const auto processor = [&app_options, &file_saver,
+   const auto processor = [&app_options, input_format, &file_saver,
                            &msh_builders](const auto& child_parent) {
-      process_chunk(child_parent.first, child_parent.second, app_options, file_saver,
-                    msh_builders);
+      process_chunk(child_parent.first, child_parent.second, app_options, input_format,
+                    file_saver, msh_builders);
    };
 
    tbb::parallel_for_each(children_parents, processor);
 
-   msh::save_all(file_saver, msh_builders, app_options.output_game_version());
+   msh::save_all(file_saver, msh_builders, app_options.output_game_version(),
+                 error_report::input_file_of(lvl_child));
 }
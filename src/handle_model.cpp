@@ -92,12 +92,12 @@ msh::Bbox create_bbox(const Model_info& model_info) noexcept
 }
 
 auto read_model_name(Ucfb_reader_strict<"NAME"_mn> name)
-   -> std::pair<std::string, msh::Lod>
+   -> std::pair<std::string_view, msh::Lod>
 {
    const auto name_view = name.read_string();
 
    const auto suffix = name_view.substr(name_view.length() - 4, 4);
-   const auto unsuffixed_name = std::string{name_view.substr(0, name_view.length() - 4)};
+   const auto unsuffixed_name = name_view.substr(0, name_view.length() - 4);
 
    if (suffix == "LOD1"_sv) {
       return {unsuffixed_name, msh::Lod::one};
@@ -109,7 +109,7 @@ auto read_model_name(Ucfb_reader_strict<"NAME"_mn> name)
       return {unsuffixed_name, msh::Lod::lowres};
    }
 
-   return {std::string{name_view}, msh::Lod::zero};
+   return {name_view, msh::Lod::zero};
 }
 
 Model_info read_model_info(Ucfb_reader_strict<"INFO"_mn> info)
@@ -485,7 +485,8 @@ void process_segment_pc(Ucfb_reader_strict<"segm"_mn> segment, const msh::Lod lo
          vbufs.emplace_back(Ucfb_reader_strict<"VBUF"_mn>{child});
       }
       else if (child.magic_number() == "BNAM"_mn) {
-         model.parent = Ucfb_reader_strict<"BNAM"_mn>{child}.read_string();
+         model.parent =
+            builder.intern(Ucfb_reader_strict<"BNAM"_mn>{child}.read_string());
       }
       else if (child.magic_number() == "BMAP"_mn) {
          model.bone_map = read_bone_map(Ucfb_reader_strict<"BMAP"_mn>{child});
@@ -527,7 +528,8 @@ void process_segment_xbox(Ucfb_reader_strict<"segm"_mn> segment, const msh::Lod
                         &model.pretransformed);
       }
       else if (child.magic_number() == "BNAM"_mn) {
-         model.parent = Ucfb_reader_strict<"BNAM"_mn>{child}.read_string();
+         model.parent =
+            builder.intern(Ucfb_reader_strict<"BNAM"_mn>{child}.read_string());
       }
       else if (child.magic_number() == "BMAP"_mn) {
          model.bone_map = read_bone_map(Ucfb_reader_strict<"BMAP"_mn>{child});
@@ -594,7 +596,8 @@ void process_segment_ps2(Ucfb_reader_strict<"segm"_mn> segment, const msh::Lod l
             read_skin_buffer(Ucfb_reader_strict<"BONE"_mn>{child}, vertex_count);
       }
       else if (child.magic_number() == "BNAM"_mn) {
-         model.parent = Ucfb_reader_strict<"BNAM"_mn>{child}.read_string();
+         model.parent =
+            builder.intern(Ucfb_reader_strict<"BNAM"_mn>{child}.read_string());
       }
    }
 
@@ -612,7 +615,7 @@ void handle_model_impl(Segm_processor&& segm_processor, Ucfb_reader model,
    model.read_child_strict<"NODE"_mn>();
    const auto model_info = read_model_info(model.read_child_strict<"INFO"_mn>());
 
-   auto& builder = builders[name];
+   auto builder = builders[name];
 
    builder.set_bbox(create_bbox(model_info));
 
@@ -1,13 +1,15 @@
 
 #include "file_saver.hpp"
+#include "logger.hpp"
 #include "magic_number.hpp"
 #include "string_helpers.hpp"
 #include "swbf_fnv_hashes.hpp"
 #include "ucfb_reader.hpp"
 
-#include <algorithm>
 #include <optional>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 using namespace std::literals;
 
@@ -29,11 +31,18 @@ void write_property(std::pair<std::string_view, std::string_view> prop_value,
    to += "\"\n"_sv;
 }
 
-auto get_properties(Ucfb_reader object)
-   -> std::vector<std::pair<std::uint32_t, std::string_view>>
-{
+struct Object_properties {
    std::vector<std::pair<std::uint32_t, std::string_view>> properties;
-   properties.reserve(128);
+   std::optional<std::string_view> geometry_name;
+   std::size_t values_length = 0;
+};
+
+auto read_properties(Ucfb_reader object) -> Object_properties
+{
+   constexpr std::uint32_t geometry_name_hash = 0x47c86b4a;
+
+   Object_properties object_properties;
+   object_properties.properties.reserve(128);
 
    while (object) {
       auto property = object.read_child_strict<"PROP"_mn>();
@@ -41,54 +50,67 @@ auto get_properties(Ucfb_reader object)
       const auto hash = property.read_trivial<std::uint32_t>();
       const auto value = property.read_string();
 
-      properties.emplace_back(hash, value);
+      if (hash == geometry_name_hash && !object_properties.geometry_name) {
+         object_properties.geometry_name = value;
+      }
+
+      object_properties.properties.emplace_back(hash, value);
+      object_properties.values_length += value.size();
    }
 
-   return properties;
+   return object_properties;
 }
 
-auto find_geometry_name(
-   const std::vector<std::pair<std::uint32_t, std::string_view>>& properties)
-   -> std::optional<std::string>
+// Resolves the property hashes against the known names in one pass, appending each
+// name straight to the buffer. Only unknown hashes need a string made for them.
+void write_properties(const Object_properties& object_properties, std::string& to)
 {
-   constexpr auto geometry_name_hash = 0x47c86b4aui32;
-
-   const auto result =
-      std::find_if(std::cbegin(properties), std::cend(properties),
-                   [](const auto& prop) { return prop.first == 0x47c86b4a; });
-
-   if (result != std::cend(properties)) return std::string{result->second} += ".msh"_sv;
-
-   return std::nullopt;
+   for (const auto& property : object_properties.properties) {
+      if (const auto name = find_fnv_hash(property.first); name) {
+         to += *name;
+      }
+      else {
+         logger::warning("Unknown hash looked up.\n"s, "   value: "s, property.first);
+
+         to += std::to_string(property.first);
+      }
+
+      to += " = \""_sv;
+      to += property.second;
+      to += "\"\n"_sv;
+   }
 }
 }
 
 void handle_object(Ucfb_reader object, File_saver& file_saver, std::string_view type)
 {
-   std::string file_buffer;
-   file_buffer.reserve(1024);
-
-   write_bracketed_str(type, file_buffer);
+   // A guess at the average length of a property's name and the text around it.
+   constexpr std::size_t property_overhead = 32;
 
    const auto class_name = object.read_child_strict<"BASE"_mn>().read_string();
+   const auto odf_name = object.read_child_strict<"TYPE"_mn>().read_string();
 
-   write_property({"ClassLabel"_sv, class_name}, file_buffer);
+   const auto object_properties = read_properties(object);
 
-   const auto odf_name = object.read_child_strict<"TYPE"_mn>().read_string();
+   std::string file_buffer;
+   file_buffer.reserve(256 + class_name.size() + object_properties.values_length +
+                       object_properties.properties.size() * property_overhead);
 
-   const auto properties = get_properties(object);
+   write_bracketed_str(type, file_buffer);
 
-   const auto geom_name = find_geometry_name(properties);
+   write_property({"ClassLabel"_sv, class_name}, file_buffer);
 
-   if (geom_name) write_property({"GeometryName"_sv, *geom_name}, file_buffer);
+   if (object_properties.geometry_name) {
+      file_buffer += "GeometryName = \""_sv;
+      file_buffer += *object_properties.geometry_name;
+      file_buffer += ".msh\"\n"_sv;
+   }
 
    file_buffer += '\n';
 
    write_bracketed_str("Properties"_sv, file_buffer);
 
-   for (const auto& property : properties) {
-      write_property({lookup_fnv_hash(property.first), property.second}, file_buffer);
-   }
+   write_properties(object_properties, file_buffer);
 
    file_saver.save_file(file_buffer, "odf"_sv, odf_name, ".odf"_sv);
-}
\ No newline at end of file
+}
@@ -1,4 +1,6 @@
 
+#include "content_hash.hpp"
+#include "error_report.hpp"
 #include "file_saver.hpp"
 #include "magic_number.hpp"
 #include "string_helpers.hpp"
@@ -9,7 +11,11 @@
 #include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
 
-#include <atomic>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <string>
 #include <vector>
 
 using namespace std::literals;
@@ -73,6 +79,19 @@ Path read_path_entry(Ucfb_reader_strict<"path"_mn> entry)
    return path;
 }
 
+// Appends a float formatted like std::to_string does, without allocating.
+void append_float(const float value, std::string& buffer)
+{
+   std::array<char, 64> chars;
+
+   const auto length = std::snprintf(chars.data(), chars.size(), "%f", value);
+
+   if (length > 0) {
+      buffer.append(chars.data(), std::min(static_cast<std::size_t>(length),
+                                           chars.size() - 1));
+   }
+}
+
 void write_node(const std::pair<glm::vec3, glm::vec4>& node, std::string& buffer)
 {
    buffer += "\t\tNode()\n\t\t{\n"_sv;
@@ -81,21 +100,21 @@ void write_node(const std::pair<glm::vec3, glm::vec4>& node, std::string& buffer
 
    buffer += indent;
    buffer += "Position("_sv;
-   buffer += std::to_string(node.first.x);
+   append_float(node.first.x, buffer);
    buffer += ", "_sv;
-   buffer += std::to_string(node.first.y);
+   append_float(node.first.y, buffer);
    buffer += ", "_sv;
-   buffer += std::to_string(node.first.z);
+   append_float(node.first.z, buffer);
    buffer += ");\n"_sv;
    buffer += indent;
    buffer += "Rotation("_sv;
-   buffer += std::to_string(node.second.x);
+   append_float(node.second.x, buffer);
    buffer += ", "_sv;
-   buffer += std::to_string(node.second.y);
+   append_float(node.second.y, buffer);
    buffer += ", "_sv;
-   buffer += std::to_string(node.second.z);
+   append_float(node.second.z, buffer);
    buffer += ", "_sv;
-   buffer += std::to_string(node.second.w);
+   append_float(node.second.w, buffer);
    buffer += ");\n"_sv;
 
    buffer += R"(
@@ -143,10 +162,40 @@ void write_path(const Path& path, std::string& buffer)
    buffer += "\t}\n}\n\n"_sv;
 }
 
-void save_paths(std::vector<Path> paths, File_saver& file_saver)
+// Names the file after the level the paths are from and the offset of their chunk in
+// it, so the name is the same on every run and unique within an output directory.
+// Paths from an unregistered source are named after a hash of their contents.
+std::string get_paths_file_name(const Ucfb_reader& chunk, std::string_view contents)
+{
+   const auto input_file = error_report::input_file_of(chunk);
+   const auto offset = error_report::offset_of(chunk);
+
+   if (input_file.empty() || !offset) {
+      return "path_"s += content_hash_string(content_hash(contents));
+   }
+
+   auto name = std::filesystem::u8path(input_file).stem().u8string();
+   name += '_';
+   name += std::to_string(*offset);
+
+   return name;
+}
+
+void save_paths(const std::vector<Path>& paths, const Ucfb_reader& chunk,
+                File_saver& file_saver)
 {
+   // The text of a node is a little over 200 characters.
+   constexpr std::size_t node_size = 256;
+   constexpr std::size_t path_size = 256;
+
+   std::size_t buffer_size = 64;
+
+   for (const auto& path : paths) {
+      buffer_size += path_size + path.name.size() + path.nodes.size() * node_size;
+   }
+
    std::string buffer;
-   buffer.reserve(2048 * paths.size());
+   buffer.reserve(buffer_size);
 
    buffer += "Version(10);\n"_sv;
    buffer += "PathCount("_sv;
@@ -157,16 +206,15 @@ void save_paths(std::vector<Path> paths, File_saver& file_saver)
       write_path(path, buffer);
    }
 
-   static std::atomic_int path_count{0};
-
-   std::string file_name = std::to_string(path_count.fetch_add(1));
-
-   file_saver.save_file(buffer, "world"s, file_name, ".pth"_sv);
+   file_saver.save_file(buffer, "world"_sv, get_paths_file_name(chunk, buffer),
+                        ".pth"_sv);
 }
 }
 
 void handle_path(Ucfb_reader path, File_saver& file_saver)
 {
+   const auto path_chunk = path;
+
    std::vector<Path> paths;
 
    while (path) {
@@ -175,5 +223,5 @@ void handle_path(Ucfb_reader path, File_saver& file_saver)
       paths.emplace_back(read_path_entry(child));
    }
 
-   save_paths(std::move(paths), file_saver);
-}
\ No newline at end of file
+   save_paths(paths, path_chunk, file_saver);
+}
@@ -24,7 +24,8 @@ struct Primitive_Data {
 static_assert(std::is_pod_v<Primitive_Data>);
 static_assert(sizeof(Primitive_Data) == 16);
 
-auto read_next_primitive(Ucfb_reader& primitives) -> msh::Collision_primitive
+auto read_next_primitive(Ucfb_reader& primitives, msh::Builder& builder)
+   -> msh::Collision_primitive
 {
    msh::Collision_primitive msh_prim;
 
@@ -37,7 +38,8 @@ auto read_next_primitive(Ucfb_reader& primitives) -> msh::Collision_primitive
          static_cast<msh::Collision_flags>(mask->read_trivial<std::uint8_t>());
    }
 
-   msh_prim.parent = primitives.read_child_strict<"PRNT"_mn>().read_string();
+   msh_prim.parent =
+      builder.intern(primitives.read_child_strict<"PRNT"_mn>().read_string());
 
    const auto xframe = primitives.read_child_strict<"XFRM"_mn>().read_trivial<Xframe>();
 
@@ -58,12 +60,12 @@ void handle_primitives(Ucfb_reader primitives, msh::Builders_map& builders)
 {
    auto info = primitives.read_child_strict<"INFO"_mn>();
 
-   std::string name{info.read_string_unaligned()};
+   const auto name = info.read_string_unaligned();
    const auto primitive_count = info.read_trivial<std::int32_t>();
 
-   auto& builder = builders[name];
+   auto builder = builders[name];
 
    for (auto i = 0; i < primitive_count; ++i) {
-      builder.add_collision_primitive(read_next_primitive(primitives));
+      builder.add_collision_primitive(read_next_primitive(primitives, builder));
    }
 }
\ No newline at end of file
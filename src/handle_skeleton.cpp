@@ -53,13 +53,13 @@ auto read_bone_xframes(Ucfb_reader_strict<"XFRM"_mn> xframes, std::size_t count)
 void add_bones(const std::vector<std::string_view>& names,
                const std::vector<std::string_view>& parents,
                const std::vector<std::pair<glm::vec3, glm::quat>>& positions,
-               msh::Builder& builder)
+               msh::Builder builder)
 {
    for (std::size_t i = 0; i < names.size(); ++i) {
       msh::Bone bone;
 
-      bone.name = names[i];
-      bone.parent = parents[i];
+      bone.name = builder.intern(names[i]);
+      bone.parent = builder.intern(parents[i]);
       bone.position = positions[i].first;
       bone.rotation = positions[i].second;
 
@@ -72,7 +72,7 @@ void handle_skeleton(Ucfb_reader skeleton, msh::Builders_map& builders)
 {
    auto info = skeleton.read_child_strict<"INFO"_mn>();
 
-   const std::string name{info.read_string_unaligned()};
+   const auto name = info.read_string_unaligned();
    const auto bone_count = info.read_trivial_unaligned<std::uint16_t>();
 
    std::vector<std::string_view> names =
@@ -0,0 +1,259 @@
+#include "chunk_handlers.hpp"
+#include "file_saver.hpp"
+#include "logger.hpp"
+#include "magic_number.hpp"
+#include "string_helpers.hpp"
+#include "swbf_fnv_hashes.hpp"
+#include "type_pun.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+// The size of the blocks samples are read from the input and written to the output in.
+constexpr std::size_t block_size = 65536;
+
+enum class Sample_format : std::uint32_t { pcm16 = 2, ima_adpcm = 3 };
+
+struct Bank_header {
+   std::uint32_t name_hash;
+   std::uint32_t sample_count;
+};
+
+static_assert(std::is_pod_v<Bank_header>);
+static_assert(sizeof(Bank_header) == 8);
+
+struct Sample_header {
+   std::uint32_t name_hash;
+   std::uint32_t sample_rate;
+   std::uint32_t data_offset;
+   std::uint32_t data_size;
+   Sample_format format;
+   std::uint32_t channels;
+};
+
+static_assert(std::is_pod_v<Sample_header>);
+static_assert(sizeof(Sample_header) == 24);
+
+struct Sound_bank {
+   std::uint32_t name_hash;
+   gsl::span<const Sample_header> samples;
+   gsl::span<const std::byte> data;
+};
+
+constexpr std::array<std::int16_t, 89> ima_step_table{
+   7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,
+   23,    25,    28,    31,    34,    37,    41,    45,    50,    55,    60,    66,
+   73,    80,    88,    97,    107,   118,   130,   143,   157,   173,   190,   209,
+   230,   253,   279,   307,   337,   371,   408,   449,   494,   544,   598,   658,
+   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+   2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,
+   7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+   22385, 24623, 27086, 29794, 32767};
+
+constexpr std::array<std::int8_t, 16> ima_index_table{-1, -1, -1, -1, 2, 4, 6, 8,
+                                                      -1, -1, -1, -1, 2, 4, 6, 8};
+
+struct Ima_channel {
+   std::int32_t predictor = 0;
+   std::int32_t step_index = 0;
+
+   std::int16_t decode(const std::uint8_t nibble) noexcept
+   {
+      const std::int32_t step = ima_step_table[step_index];
+
+      std::int32_t difference = step >> 3;
+
+      if (nibble & 4) difference += step;
+      if (nibble & 2) difference += step >> 1;
+      if (nibble & 1) difference += step >> 2;
+      if (nibble & 8) difference = -difference;
+
+      predictor = std::clamp(predictor + difference, -32768, 32767);
+      step_index = std::clamp(step_index + ima_index_table[nibble], 0, 88);
+
+      return static_cast<std::int16_t>(predictor);
+   }
+};
+
+std::string create_wav_header(const Sample_header& sample, const std::size_t data_size)
+{
+   constexpr std::uint16_t pcm_format = 1;
+   constexpr std::uint16_t bits_per_sample = 16;
+
+   const auto channels = static_cast<std::uint16_t>(sample.channels);
+   const auto block_align = static_cast<std::uint16_t>(channels * bits_per_sample / 8);
+
+   std::string header;
+   header.reserve(44);
+
+   header += "RIFF"_sv;
+   header += view_pod_as_string(static_cast<std::uint32_t>(36 + data_size));
+   header += "WAVEfmt "_sv;
+   header += view_pod_as_string(std::uint32_t{16});
+   header += view_pod_as_string(pcm_format);
+   header += view_pod_as_string(channels);
+   header += view_pod_as_string(sample.sample_rate);
+   header += view_pod_as_string(sample.sample_rate * block_align);
+   header += view_pod_as_string(block_align);
+   header += view_pod_as_string(bits_per_sample);
+   header += "data"_sv;
+   header += view_pod_as_string(static_cast<std::uint32_t>(data_size));
+
+   return header;
+}
+
+void write_pcm16(gsl::span<const std::byte> data, const File_saver::Block_sink& sink)
+{
+   const auto chars = reinterpret_cast<const char*>(data.data());
+   const auto size = static_cast<std::size_t>(data.size());
+
+   for (std::size_t offset = 0; offset < size; offset += block_size) {
+      sink({chars + offset, std::min(block_size, size - offset)});
+   }
+}
+
+// Decodes the data in blocks, each byte holds two samples. Mono samples are stored low
+// nibble first and stereo samples hold the left channel in the low nibble.
+void write_ima_adpcm(gsl::span<const std::byte> data, const std::uint32_t channels,
+                     const File_saver::Block_sink& sink)
+{
+   std::array<Ima_channel, 2> states;
+   auto& first = states[0];
+   auto& second = channels == 2 ? states[1] : states[0];
+
+   std::vector<std::int16_t> samples(block_size * 2);
+
+   const auto size = static_cast<std::size_t>(data.size());
+
+   for (std::size_t offset = 0; offset < size; offset += block_size) {
+      const auto count = std::min(block_size, size - offset);
+
+      for (std::size_t i = 0; i < count; ++i) {
+         const auto byte = static_cast<std::uint8_t>(data[offset + i]);
+
+         samples[i * 2] = first.decode(byte & 0xf);
+         samples[i * 2 + 1] = second.decode(byte >> 4);
+      }
+
+      sink({reinterpret_cast<const char*>(samples.data()),
+            count * 2 * sizeof(std::int16_t)});
+   }
+}
+
+std::string get_sample_name(const std::uint32_t name_hash)
+{
+   if (const auto name = find_fnv_hash(name_hash); name) return std::string{*name};
+
+   std::array<char, 16> hash;
+   std::snprintf(hash.data(), hash.size(), "%08x", name_hash);
+
+   return hash.data();
+}
+
+// Reads and checks a bank's layout and samples, nothing is saved until every sample in
+// the bank is known to be convertible.
+auto read_sound_bank(Ucfb_reader bank) -> Sound_bank
+{
+   constexpr auto info_mn = static_cast<Magic_number>("Info"_fnv);
+   constexpr auto data_mn = static_cast<Magic_number>("Data"_fnv);
+
+   auto info = bank.read_child_strict<info_mn>();
+   auto data = bank.read_child_strict<data_mn>();
+
+   const auto header = info.read_trivial<Bank_header>();
+
+   // The samples are read straight from the input as they are written out, the bank is
+   // never copied.
+   Sound_bank sound_bank{header.name_hash,
+                         info.read_array<Sample_header>(header.sample_count),
+                         data.read_array<std::byte>(data.size())};
+
+   for (const auto& sample : sound_bank.samples) {
+      if (static_cast<std::size_t>(sample.data_offset) + sample.data_size >
+          static_cast<std::size_t>(sound_bank.data.size())) {
+         throw std::runtime_error{"Sample data is outside of its sound bank."};
+      }
+
+      if (sample.channels != 1 && sample.channels != 2) {
+         throw std::runtime_error{"Sample "s + get_sample_name(sample.name_hash) +
+                                  " has "s + std::to_string(sample.channels) +
+                                  " channels."s};
+      }
+
+      if (sample.format != Sample_format::pcm16 &&
+          sample.format != Sample_format::ima_adpcm) {
+         throw std::runtime_error{
+            "Sample "s + get_sample_name(sample.name_hash) + " has unknown format "s +
+            std::to_string(static_cast<std::uint32_t>(sample.format)) + '.'};
+      }
+   }
+
+   return sound_bank;
+}
+
+void save_sample(const Sample_header& sample, gsl::span<const std::byte> bank_data,
+                 std::string_view directory, File_saver& file_saver)
+{
+   const auto sample_name = get_sample_name(sample.name_hash);
+
+   const auto data = bank_data.subspan(sample.data_offset, sample.data_size);
+
+   if (sample.format == Sample_format::pcm16) {
+      file_saver.save_file_blocks(directory, sample_name, ".wav"_sv,
+                                  [&](const File_saver::Block_sink& sink) {
+                                     sink(create_wav_header(sample, sample.data_size));
+                                     write_pcm16(data, sink);
+                                  });
+   }
+   else {
+      const std::size_t decoded_size = std::size_t{sample.data_size} * 4;
+
+      file_saver.save_file_blocks(directory, sample_name, ".wav"_sv,
+                                  [&](const File_saver::Block_sink& sink) {
+                                     sink(create_wav_header(sample, decoded_size));
+                                     write_ima_adpcm(data, sample.channels, sink);
+                                  });
+   }
+}
+}
+
+void handle_sound_bank(Ucfb_reader bank, File_saver& file_saver)
+{
+   std::optional<Sound_bank> sound_bank;
+
+   try {
+      sound_bank = read_sound_bank(bank);
+   }
+   catch (const std::exception& e) {
+      file_saver.mark_incomplete();
+
+      logger::warning("Unable to convert sound bank, saving it as is.\n   Message: "s,
+                      e.what());
+
+      handle_unknown(bank, file_saver);
+
+      return;
+   }
+
+   const auto bank_name = get_sample_name(sound_bank->name_hash);
+
+   auto sound_saver = file_saver.create_nested("sound"_sv);
+
+   for (const auto& sample : sound_bank->samples) {
+      save_sample(sample, sound_bank->data, bank_name, sound_saver);
+   }
+}
@@ -3,8 +3,8 @@
 #include "DDS.h"
 #include "app_options.hpp"
 #include "file_saver.hpp"
+#include "logger.hpp"
 #include "save_image.hpp"
-#include "synced_cout.hpp"
 #include "ucfb_reader.hpp"
 
 #include <DirectXTex.h>
@@ -129,8 +129,8 @@ auto resolve_detail_compression(DirectX::ScratchImage colour_image,
       detail_image.GetMetadata().height, DirectX::TEX_FILTER_DEFAULT, resized);
 
    if (!SUCCEEDED(result)) {
-      synced_cout::print("Warning: Failed to resize colour texture in order to resolve "
-                         "detail compression.\n");
+      logger::warning("Failed to resize colour texture in order to resolve detail "
+                      "compression.");
 
       return colour_image;
    }
@@ -178,7 +178,7 @@ auto read_palette(Ucfb_reader_strict<"pal_"_mn> pal) -> std::vector<std::uint32_
    const auto unknown = info.read_trivial_unaligned<std::uint16_t>();
 
    if (unknown != 32) {
-      synced_cout::print("Warning: Potentially unknown palette type encountered.");
+      logger::warning("Potentially unknown palette type encountered.");
    }
 
    auto body = pal.read_child_strict<"BODY"_mn>();
@@ -235,8 +235,7 @@ auto read_texture(Ucfb_reader_strict<"tex_"_mn> tex, Ucfb_reader parent_reader)
       }
 
       if (!success) {
-         synced_cout::print("Warning: Failed to read detail texture.\n   texture:",
-                            name.data());
+         logger::warning("Failed to read detail texture.\n   texture:", name.data());
       }
    }
 
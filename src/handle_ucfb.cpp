@@ -1,27 +1,135 @@
-
 #include "chunk_processor.hpp"
+#include "error_report.hpp"
+#include "extract_cache.hpp"
+#include "file_saver.hpp"
 
 #include "tbb/parallel_for_each.h"
+#include "tbb/parallel_invoke.h"
 
+#include <cstdint>
+#include <utility>
 #include <vector>
 
+namespace {
+
+using Children_parents = std::vector<std::pair<Ucfb_reader, Ucfb_reader>>;
+
+// The chunks whose handlers add to msh::Builders_map. A .msh file is built from several
+// of these so they can only be skipped or extracted as a group.
+bool feeds_msh_builders(const Magic_number magic_number) noexcept
+{
+   return magic_number == "skel"_mn || magic_number == "modl"_mn ||
+          magic_number == "coll"_mn || magic_number == "prim"_mn ||
+          magic_number == "CLTH"_mn;
+}
+
+void process_cached_chunks(const Children_parents& children_parents,
+                           const App_options& app_options,
+                           const Input_format input_format, File_saver& file_saver,
+                           Extract_cache& cache)
+{
+   // Only model chunks ever add to this and they are processed separately below.
+   msh::Builders_map unused_msh_builders;
+
+   tbb::parallel_for_each(children_parents, [&](const auto& child_parent) {
+      const auto key = cache.chunk_key(child_parent.first);
+
+      if (cache.up_to_date(key)) return;
+
+      auto chunk_saver = file_saver.create_sibling();
+
+      process_chunk(child_parent.first, child_parent.second, app_options, input_format,
+                    chunk_saver, unused_msh_builders);
+
+      if (chunk_saver.complete()) cache.store(key, chunk_saver.output_files());
+   });
+}
+
+void process_cached_models(const Children_parents& children_parents,
+                           const App_options& app_options,
+                           const Input_format input_format, File_saver& file_saver,
+                           Extract_cache& cache)
+{
+   if (children_parents.empty()) return;
+
+   std::vector<std::uint64_t> keys;
+   keys.reserve(children_parents.size());
+
+   for (const auto& child_parent : children_parents) {
+      keys.emplace_back(cache.chunk_key(child_parent.first));
+   }
+
+   const auto key = cache.combine_keys(keys);
+
+   if (cache.up_to_date(key)) return;
+
+   auto models_saver = file_saver.create_sibling();
+   msh::Builders_map msh_builders;
+
+   tbb::parallel_for_each(children_parents, [&](const auto& child_parent) {
+      process_chunk(child_parent.first, child_parent.second, app_options, input_format,
+                    models_saver, msh_builders);
+   });
+
+   msh::save_all(models_saver, msh_builders, app_options.output_game_version(),
+                 error_report::input_file_of(children_parents.front().second));
+
+   if (models_saver.complete()) cache.store(key, models_saver.output_files());
+}
+
+void handle_ucfb_cached(const Children_parents& children_parents,
+                        const App_options& app_options, const Input_format input_format,
+                        File_saver& file_saver, Extract_cache& cache)
+{
+   Children_parents model_chunks;
+   Children_parents other_chunks;
+   other_chunks.reserve(children_parents.size());
+
+   for (const auto& child_parent : children_parents) {
+      if (feeds_msh_builders(child_parent.first.magic_number())) {
+         model_chunks.emplace_back(child_parent);
+      }
+      else {
+         other_chunks.emplace_back(child_parent);
+      }
+   }
+
+   tbb::parallel_invoke(
+      [&] {
+         process_cached_chunks(other_chunks, app_options, input_format, file_saver,
+                               cache);
+      },
+      [&] {
+         process_cached_models(model_chunks, app_options, input_format, file_saver,
+                               cache);
+      });
+}
+}
+
 void handle_ucfb(Ucfb_reader chunk, const App_options& app_options,
-                 File_saver& file_saver)
+                 const Input_format input_format, File_saver& file_saver,
+                 Extract_cache* cache)
 {
-   std::vector<std::pair<Ucfb_reader, Ucfb_reader>> children_parents;
+   Children_parents children_parents;
    children_parents.reserve(32);
 
    while (chunk) children_parents.emplace_back(chunk.read_child(), chunk);
 
+   if (cache) {
+      return handle_ucfb_cached(children_parents, app_options, input_format, file_saver,
+                                *cache);
+   }
+
    msh::Builders_map msh_builders;
 
-   const auto processor = [&app_options, &file_saver,
+   const auto processor = [&app_options, input_format, &file_saver,
                            &msh_builders](const auto& child_parent) {
-      process_chunk(child_parent.first, child_parent.second, app_options, file_saver,
-                    msh_builders);
+      process_chunk(child_parent.first, child_parent.second, app_options, input_format,
+                    file_saver, msh_builders);
    };
 
    tbb::parallel_for_each(children_parents, processor);
 
-   msh::save_all(file_saver, msh_builders, app_options.output_game_version());
+   msh::save_all(file_saver, msh_builders, app_options.output_game_version(),
+                 error_report::input_file_of(chunk));
 }
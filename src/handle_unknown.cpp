@@ -1,11 +1,11 @@
 
+#include "content_hash.hpp"
 #include "file_saver.hpp"
 #include "magic_number.hpp"
 #include "string_helpers.hpp"
 #include "type_pun.hpp"
 #include "ucfb_reader.hpp"
 
-#include <atomic>
 #include <optional>
 #include <string>
 
@@ -13,13 +13,14 @@ namespace {
 
 using namespace std::literals;
 
-std::string get_unique_chunk_name() noexcept
+// Names the chunk after a hash of it's munged contents. The name is the same from run to
+// run regardless of the order chunks get processed in, and identical chunks simply
+// produce the same file.
+std::string get_unique_chunk_name(std::string_view munged_chunk) noexcept
 {
-   static std::atomic_int64_t chunk_count{0};
-
    std::string result{"chunk_"s};
 
-   result += std::to_string(chunk_count.fetch_add(1));
+   result += content_hash_string(content_hash(munged_chunk));
 
    return result;
 }
@@ -38,6 +39,7 @@ void handle_unknown(Ucfb_reader chunk, File_saver& file_saver,
    file += view_pod_as_string(static_cast<std::uint32_t>(chunk.size()));
    file += view_pod_span_as_string(chunk.read_array<std::byte>(chunk.size()));
 
-   file_saver.save_file(file, "munged", file_name ? *file_name : get_unique_chunk_name(),
+   file_saver.save_file(file, "munged",
+                        file_name ? *file_name : get_unique_chunk_name(file),
                         file_extension ? *file_extension : ".munged"_sv);
 }
@@ -0,0 +1,197 @@
+#include "input_discovery.hpp"
+#include "string_helpers.hpp"
+
+#include "tbb/concurrent_unordered_set.h"
+#include "tbb/concurrent_vector.h"
+#include "tbb/task_group.h"
+
+#include <cctype>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+namespace fs = std::filesystem;
+using namespace std::literals;
+
+namespace {
+
+using Components = std::vector<std::string>;
+
+struct Glob {
+   fs::path root;
+   Components components;
+};
+
+class Walk_context {
+public:
+   Walk_context(const bool match_directories,
+                const std::function<void(const std::string&)>& process)
+      : match_directories{match_directories}, _process{process}
+   {
+   }
+
+   void found(const fs::path& path)
+   {
+      auto input = path.lexically_normal().u8string();
+
+      if (!_found.insert(input).second) return;
+
+      tasks.run([this, input = std::move(input)] { _process(input); });
+   }
+
+   tbb::task_group tasks;
+   const bool match_directories;
+
+private:
+   const std::function<void(const std::string&)>& _process;
+   tbb::concurrent_unordered_set<std::string> _found;
+};
+
+bool has_wildcard(std::string_view path) noexcept
+{
+   return path.find_first_of("*?"_sv) != path.npos;
+}
+
+auto split_glob(std::string_view pattern) -> Glob
+{
+   Glob glob;
+
+   bool in_root = true;
+
+   for (const auto& component : fs::u8path(pattern)) {
+      auto string = component.u8string();
+
+      if (in_root && !has_wildcard(string)) {
+         glob.root /= component;
+
+         continue;
+      }
+
+      in_root = false;
+      glob.components.emplace_back(std::move(string));
+   }
+
+   // A trailing '**' matches everything below it.
+   if (glob.components.back() == "**"_sv) glob.components.emplace_back("*"s);
+
+   if (glob.root.empty()) glob.root = "."s;
+
+   return glob;
+}
+
+void walk(Walk_context& context, const Components& components, const fs::path& directory,
+          const std::size_t index)
+{
+   const auto& component = components[index];
+   const bool last = (index + 1 == components.size());
+
+   std::error_code error;
+   fs::directory_iterator iterator{directory, fs::directory_options::skip_permission_denied,
+                                   error};
+
+   if (error) return;
+
+   if (component == "**"_sv) {
+      walk(context, components, directory, index + 1);
+
+      // Links are not followed, a link back up the tree would be walked forever. Checking
+      // the entry's own status skips junctions as well as symlinks.
+      for (const auto& entry : iterator) {
+         if (!fs::is_directory(entry.symlink_status(error))) continue;
+
+         context.tasks.run([&context, &components, path = entry.path(), index] {
+            walk(context, components, path, index);
+         });
+      }
+
+      return;
+   }
+
+   for (const auto& entry : iterator) {
+      if (!match_wildcard(component, entry.path().filename().u8string())) continue;
+
+      const bool is_directory = entry.is_directory(error);
+
+      if (last) {
+         if (!is_directory || context.match_directories) context.found(entry.path());
+      }
+      else if (is_directory) {
+         context.tasks.run([&context, &components, path = entry.path(), index] {
+            walk(context, components, path, index + 1);
+         });
+      }
+   }
+}
+}
+
+void for_each_input(const std::vector<std::string>& inputs, const bool match_directories,
+                    const std::function<void(const std::string&)>& process)
+{
+   Walk_context context{match_directories, process};
+
+   std::vector<Glob> globs;
+
+   for (const auto& input : inputs) {
+      if (has_wildcard(input)) {
+         globs.emplace_back(split_glob(input));
+      }
+      else {
+         context.found(fs::u8path(input));
+      }
+   }
+
+   for (const auto& glob : globs) {
+      context.tasks.run(
+         [&context, &glob] { walk(context, glob.components, glob.root, 0); });
+   }
+
+   context.tasks.wait();
+}
+
+auto find_inputs(const std::vector<std::string>& inputs, const bool match_directories)
+   -> std::vector<std::string>
+{
+   tbb::concurrent_vector<std::string> found;
+
+   for_each_input(inputs, match_directories,
+                  [&found](const std::string& input) { found.push_back(input); });
+
+   return {std::make_move_iterator(found.begin()), std::make_move_iterator(found.end())};
+}
+
+bool match_wildcard(std::string_view pattern, std::string_view name) noexcept
+{
+   const auto equal = [](const char left, const char right) {
+      return std::tolower(static_cast<unsigned char>(left)) ==
+             std::tolower(static_cast<unsigned char>(right));
+   };
+
+   std::size_t pattern_index = 0;
+   std::size_t name_index = 0;
+   std::size_t star_index = pattern.npos;
+   std::size_t star_match = 0;
+
+   while (name_index < name.size()) {
+      if (pattern_index < pattern.size() &&
+          (pattern[pattern_index] == '?' ||
+           equal(pattern[pattern_index], name[name_index]))) {
+         ++pattern_index;
+         ++name_index;
+      }
+      else if (pattern_index < pattern.size() && pattern[pattern_index] == '*') {
+         star_index = pattern_index++;
+         star_match = name_index;
+      }
+      else if (star_index != pattern.npos) {
+         pattern_index = star_index + 1;
+         name_index = ++star_match;
+      }
+      else {
+         return false;
+      }
+   }
+
+   while (pattern_index < pattern.size() && pattern[pattern_index] == '*') ++pattern_index;
+
+   return pattern_index == pattern.size();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! \brief Finds the input files named by a list of paths and glob patterns and processes
+//! them in parallel.
+//!
+//! Patterns may use '*' and '?' within a path component and '**' as a component to match
+//! any number of directories, for instance "GameData/**/*.lvl". Paths without wildcards
+//! are passed on as they are.
+//!
+//! Directories are walked in parallel and each input is handed to process as soon as it
+//! is found, so processing starts before the walk is finished. process may be called
+//! concurrently and each input is only passed to it once.
+//!
+//! \param inputs The paths and patterns to expand.
+//! \param match_directories If patterns match directories as well as files.
+//! \param process The function to call for each input.
+void for_each_input(const std::vector<std::string>& inputs, const bool match_directories,
+                    const std::function<void(const std::string&)>& process);
+
+//! \brief Finds all the input files named by a list of paths and glob patterns.
+auto find_inputs(const std::vector<std::string>& inputs, const bool match_directories)
+   -> std::vector<std::string>;
+
+//! \brief Checks if a file name matches a pattern using '*' and '?' wildcards. Letters
+//! are compared without case, as they are by the file system.
+bool match_wildcard(std::string_view pattern, std::string_view name) noexcept;
@@ -0,0 +1,155 @@
+#include "input_format.hpp"
+#include "magic_number.hpp"
+#include "string_helpers.hpp"
+
+#include <exception>
+#include <string>
+#include <optional>
+
+namespace {
+
+// How many chunks are looked at before settling for the defaults.
+constexpr int max_examined_chunks = 256;
+
+// The size of the INFO chunk of an Xbox texture, PS2 texture INFO chunks are smaller.
+constexpr std::size_t xbox_texture_info_size = 20;
+
+// The size of a model's INFO chunk. SWBF II has an array of four ints at the start
+// where SWBF has three.
+constexpr std::size_t swbf_ii_model_info_size = 72;
+constexpr std::size_t swbf_model_info_size = 68;
+
+struct Detection {
+   std::optional<Input_platform> platform;
+   std::optional<Game_version> game_version;
+   int examined_chunks = 0;
+
+   bool done() const noexcept
+   {
+      return (platform && game_version) || examined_chunks >= max_examined_chunks;
+   }
+};
+
+void examine_texture(Ucfb_reader texture, Detection& detection)
+{
+   if (detection.platform) return;
+
+   texture.read_child_strict<"NAME"_mn>();
+   const auto info = texture.read_child_strict<"INFO"_mn>();
+   const auto data = texture.read_child();
+
+   // PC textures have a FMT_ chunk per format, consoles go straight to the data.
+   if (data.magic_number() == "FMT_"_mn) {
+      detection.platform = Input_platform::pc;
+   }
+   else if (data.magic_number() == "pal_"_mn) {
+      detection.platform = Input_platform::ps2;
+   }
+   else if (data.magic_number() == "BODY"_mn) {
+      detection.platform = (info.size() >= xbox_texture_info_size) ? Input_platform::xbox
+                                                                   : Input_platform::ps2;
+   }
+}
+
+void examine_model(Ucfb_reader model, Detection& detection)
+{
+   model.read_child_strict<"NAME"_mn>();
+   model.read_child_strict_optional<"VRTX"_mn>();
+   model.read_child_strict<"NODE"_mn>();
+
+   const auto info = model.read_child_strict<"INFO"_mn>();
+
+   if (!detection.game_version) {
+      if (info.size() == swbf_ii_model_info_size) {
+         detection.game_version = Game_version::swbf_ii;
+      }
+      else if (info.size() == swbf_model_info_size) {
+         detection.game_version = Game_version::swbf;
+      }
+   }
+
+   if (detection.platform) return;
+
+   while (model) {
+      auto child = model.read_child();
+
+      if (child.magic_number() != "segm"_mn) continue;
+
+      // Only PS2 segments start with their own INFO chunk.
+      if (child.read_child().magic_number() == "INFO"_mn) {
+         detection.platform = Input_platform::ps2;
+      }
+
+      return;
+   }
+}
+
+void examine_children(Ucfb_reader parent, Detection& detection)
+{
+   while (parent && !detection.done()) {
+      const auto child = parent.read_child();
+
+      ++detection.examined_chunks;
+
+      // A chunk that does not look like expected says nothing about the format.
+      try {
+         if (child.magic_number() == "tex_"_mn) {
+            examine_texture(child, detection);
+         }
+         else if (child.magic_number() == "modl"_mn) {
+            examine_model(child, detection);
+         }
+         else if (child.magic_number() == "PATH"_mn && !detection.game_version) {
+            detection.game_version = Game_version::swbf;
+         }
+         else if (child.magic_number() == "lvl_"_mn) {
+            auto lvl_child = child;
+
+            lvl_child.consume(4); // lvl name hash
+            lvl_child.consume(4); // lvl size left
+
+            examine_children(lvl_child, detection);
+         }
+      }
+      catch (const std::exception&) {
+      }
+   }
+}
+}
+
+auto detect_input_format(Ucfb_reader root, const App_options& options) -> Input_format
+{
+   Detection detection;
+   detection.platform = options.platform_override();
+   detection.game_version = options.game_version_override();
+
+   try {
+      examine_children(root, detection);
+   }
+   catch (const std::exception&) {
+   }
+
+   return {detection.platform.value_or(Input_platform::pc),
+           detection.game_version.value_or(Game_version::swbf_ii)};
+}
+
+auto to_string(const Input_format format) -> std::string
+{
+   std::string string;
+
+   switch (format.platform) {
+   case Input_platform::pc:
+      string += "pc"_sv;
+      break;
+   case Input_platform::ps2:
+      string += "ps2"_sv;
+      break;
+   case Input_platform::xbox:
+      string += "xbox"_sv;
+      break;
+   }
+
+   string += (format.game_version == Game_version::swbf) ? " swbf"_sv : " swbf_ii"_sv;
+
+   return string;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "app_options.hpp"
+#include "ucfb_reader.hpp"
+
+#include <string>
+
+//! \brief Works out the platform and game version an input file was munged for.
+//!
+//! Looks at the layout of the first few texture and model chunks and for chunks only
+//! one game has. This is cheap as only chunk headers and a handful of small chunks are
+//! read. The '-platform' and '-version' options override what is detected and anything
+//! that can not be detected falls back to the defaults, PC and SWBF II.
+//!
+//! \param root The root chunk of the input file.
+//! \param options The app options, for the overrides.
+auto detect_input_format(Ucfb_reader root, const App_options& options) -> Input_format;
+
+//! \brief Names an input format the way the '-platform' and '-version' options do,
+//! for instance "pc swbf_ii".
+auto to_string(const Input_format format) -> std::string;
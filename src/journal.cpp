@@ -0,0 +1,182 @@
+#include "journal.hpp"
+#include "content_hash.hpp"
+#include "file_saver.hpp"
+#include "string_helpers.hpp"
+#include "type_pun.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std::literals;
+
+namespace {
+
+constexpr auto journal_header = "swbf-unmunge-journal 1"_sv;
+
+// Identifies the options that change what a mode outputs. Inputs processed with other
+// options are done again.
+std::string options_stamp(const App_options& options)
+{
+   std::string string;
+
+   string += view_pod_as_string(options.output_game_version());
+   string += view_pod_as_string(options.image_save_format());
+
+   const auto platform = options.platform_override();
+   const auto game_version = options.game_version_override();
+
+   string += platform ? std::to_string(static_cast<int>(*platform)) : "auto"s;
+   string += ' ';
+   string += game_version ? std::to_string(static_cast<int>(*game_version)) : "auto"s;
+   string += '\n';
+   string += options.patch_chunk();
+   string += '\n';
+   string += options.patch_file();
+   string += '\n';
+
+   for (const auto& query : options.config_queries()) {
+      string += query;
+      string += '\n';
+   }
+
+   return content_hash_string(content_hash(string));
+}
+
+std::string file_stamp(const fs::path& file)
+{
+   std::string stamp;
+
+   stamp += std::to_string(fs::file_size(file));
+   stamp += ' ';
+   stamp += std::to_string(fs::last_write_time(file).time_since_epoch().count());
+
+   return stamp;
+}
+
+// Editing a file inside a directory does not touch the directory's own modification
+// time, so directories are stamped with the path, size and modification time of every
+// file below them.
+std::string directory_stamp(const fs::path& directory)
+{
+   std::vector<std::string> file_stamps;
+
+   for (const auto& entry : fs::recursive_directory_iterator{directory}) {
+      if (!entry.is_regular_file()) continue;
+
+      auto stamp = fs::relative(entry.path(), directory).u8string();
+      stamp += ' ';
+      stamp += file_stamp(entry.path());
+
+      file_stamps.emplace_back(std::move(stamp));
+   }
+
+   std::sort(file_stamps.begin(), file_stamps.end());
+
+   std::string files;
+
+   for (const auto& stamp : file_stamps) {
+      files += stamp;
+      files += '\n';
+   }
+
+   std::string stamp;
+
+   stamp += std::to_string(file_stamps.size());
+   stamp += ' ';
+   stamp += content_hash_string(content_hash(files));
+
+   return stamp;
+}
+
+// Identifies the exact version of an input file, as far as the file system can tell.
+std::string input_stamp(const fs::path& input_file, const Tool_mode tool_mode,
+                        std::string_view options_stamp)
+{
+   std::string stamp;
+
+   stamp += std::to_string(static_cast<int>(tool_mode));
+   stamp += ' ';
+   stamp += options_stamp;
+   stamp += ' ';
+
+   if (fs::is_directory(input_file)) {
+      stamp += "directory "_sv;
+      stamp += directory_stamp(input_file);
+   }
+   else {
+      stamp += file_stamp(input_file);
+   }
+
+   return stamp;
+}
+}
+
+Journal::Journal(fs::path directory, const App_options& options)
+   : _directory{std::move(directory)},
+     _tool_mode{options.tool_mode()},
+     _options_stamp{options_stamp(options)}
+{
+   fs::create_directories(_directory);
+}
+
+bool Journal::finished(const fs::path& input_file) const
+{
+   std::ifstream file{entry_path(input_file), std::ios::binary};
+
+   if (!file) return false;
+
+   std::string line;
+
+   if (!std::getline(file, line) || line != journal_header) return false;
+   if (!std::getline(file, line) || line != fs::absolute(input_file).u8string()) {
+      return false;
+   }
+   if (!std::getline(file, line) ||
+       line != input_stamp(input_file, _tool_mode, _options_stamp)) {
+      return false;
+   }
+
+   while (std::getline(file, line)) {
+      std::error_code error;
+
+      if (!fs::exists(fs::u8path(line), error)) return false;
+   }
+
+   return true;
+}
+
+void Journal::record(const fs::path& input_file,
+                     const std::vector<std::string>& output_files) const
+{
+   std::string entry;
+
+   entry += journal_header;
+   entry += '\n';
+   entry += fs::absolute(input_file).u8string();
+   entry += '\n';
+   entry += input_stamp(input_file, _tool_mode, _options_stamp);
+   entry += '\n';
+
+   for (const auto& output : output_files) {
+      entry += output;
+      entry += '\n';
+   }
+
+   save_file_atomically(entry_path(input_file), entry);
+}
+
+auto Journal::entry_path(const fs::path& input_file) const -> fs::path
+{
+   // Runs in different modes keep separate entries for the same input.
+   auto name = input_file.stem().u8string();
+   name += '_';
+   name += std::to_string(static_cast<int>(_tool_mode));
+   name += '_';
+   name += content_hash_string(content_hash(fs::absolute(input_file).u8string()));
+   name += ".entry"_sv;
+
+   return _directory / fs::u8path(name);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "app_options.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+//! \brief Records which input files a batch run has finished and what they output.
+//!
+//! Each finished input gets its own small entry file in the journal directory, written
+//! under a temporary name and renamed into place. An interrupted run therefore never
+//! leaves a half written entry and recording an input never rewrites the others.
+//!
+//! An input counts as finished if its entry was made by the same tool mode with the same
+//! output affecting options, its size and modification time are unchanged and all the outputs listed still exist. Inputs
+//! that are directories, such as exploded files, count as unchanged while no file
+//! below them has been added, removed, resized or modified.
+//!
+//! Instances are threadsafe.
+class Journal {
+public:
+   Journal(std::filesystem::path directory, const App_options& options);
+
+   bool finished(const std::filesystem::path& input_file) const;
+
+   void record(const std::filesystem::path& input_file,
+               const std::vector<std::string>& output_files) const;
+
+private:
+   auto entry_path(const std::filesystem::path& input_file) const
+      -> std::filesystem::path;
+
+   const std::filesystem::path _directory;
+   const Tool_mode _tool_mode;
+   const std::string _options_stamp;
+};
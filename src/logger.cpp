@@ -0,0 +1,301 @@
+#include "logger.hpp"
+#include "string_helpers.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace logger {
+
+namespace {
+
+struct Message {
+   std::uint64_t sequence = 0;
+   Log_level level = Log_level::info;
+   bool raw = false;
+   std::string text;
+};
+
+// Ring of messages with a single producer, the thread that owns it, and a single
+// consumer, whoever holds the writer's write mutex.
+class Message_ring {
+public:
+   bool try_push(Message& message) noexcept
+   {
+      const auto tail = _tail.load(std::memory_order_relaxed);
+
+      if (tail - _head.load(std::memory_order_acquire) == capacity) return false;
+
+      _messages[tail % capacity] = std::move(message);
+      _tail.store(tail + 1, std::memory_order_release);
+
+      return true;
+   }
+
+   void drain(std::vector<Message>& out)
+   {
+      const auto head = _head.load(std::memory_order_relaxed);
+      const auto tail = _tail.load(std::memory_order_acquire);
+
+      for (auto i = head; i != tail; ++i) {
+         out.emplace_back(std::move(_messages[i % capacity]));
+      }
+
+      _head.store(tail, std::memory_order_release);
+   }
+
+private:
+   constexpr static std::size_t capacity = 256;
+
+   std::array<Message, capacity> _messages;
+
+   alignas(64) std::atomic_size_t _head{0};
+   alignas(64) std::atomic_size_t _tail{0};
+};
+
+class Log_writer {
+public:
+   static Log_writer& get() noexcept
+   {
+      static Log_writer writer;
+
+      return writer;
+   }
+
+   void start(const Log_level min_level, const Log_format format)
+   {
+      _min_level = min_level;
+      _format = format;
+
+      std::lock_guard<std::mutex> lock{_mutex};
+
+      if (_running) return;
+
+      _running = true;
+      _thread = std::thread{[this] { run(); }};
+   }
+
+   void stop() noexcept
+   {
+      {
+         std::lock_guard<std::mutex> lock{_mutex};
+
+         if (!_running) return;
+
+         _running = false;
+      }
+
+      _wake.notify_one();
+      _thread.join();
+   }
+
+   void flush() noexcept
+   {
+      const auto target = _next_sequence.load();
+
+      std::unique_lock<std::mutex> lock{_mutex};
+
+      if (!_running) {
+         lock.unlock();
+         write_pending();
+
+         return;
+      }
+
+      _wake.notify_one();
+      _written_cv.wait(lock, [&] { return _written.load() >= target; });
+   }
+
+   bool enabled(const Log_level level) const noexcept
+   {
+      return level >= _min_level.load(std::memory_order_relaxed);
+   }
+
+   void push(Message message) noexcept
+   {
+      message.sequence = _next_sequence.fetch_add(1);
+
+      auto& ring = thread_ring();
+
+      while (!ring.try_push(message)) {
+         if (!_running) {
+            write_pending();
+         }
+         else {
+            _wake.notify_one();
+            std::this_thread::yield();
+         }
+      }
+   }
+
+private:
+   Log_writer() = default;
+
+   ~Log_writer()
+   {
+      stop();
+   }
+
+   void run() noexcept
+   {
+      std::unique_lock<std::mutex> lock{_mutex};
+
+      while (_running) {
+         _wake.wait_for(lock, 10ms);
+
+         lock.unlock();
+         write_pending();
+         lock.lock();
+
+         _written_cv.notify_all();
+      }
+
+      lock.unlock();
+      write_pending();
+
+      _written_cv.notify_all();
+   }
+
+   void write_pending() noexcept
+   {
+      std::lock_guard<std::mutex> lock{_write_mutex};
+
+      _pending.clear();
+
+      {
+         std::lock_guard<std::mutex> rings_lock{_rings_mutex};
+
+         for (auto& ring : _rings) ring->drain(_pending);
+      }
+
+      if (_pending.empty()) return;
+
+      std::sort(std::begin(_pending), std::end(_pending),
+                [](const Message& left, const Message& right) {
+                   return left.sequence < right.sequence;
+                });
+
+      _buffer.clear();
+
+      for (const auto& message : _pending) format(message);
+
+      std::cout.write(_buffer.data(), _buffer.size());
+      std::cout.flush();
+
+      _written += _pending.size();
+   }
+
+   void format(const Message& message)
+   {
+      if (message.raw) {
+         _buffer += message.text;
+      }
+      else if (_format == Log_format::json) {
+         _buffer += R"({"level":")"_sv;
+         _buffer += level_name(message.level);
+         _buffer += R"(","message":")"_sv;
+         _buffer += json_escape(message.text);
+         _buffer += R"("})"_sv;
+      }
+      else {
+         _buffer += level_prefix(message.level);
+         _buffer += message.text;
+      }
+
+      _buffer += '\n';
+   }
+
+   static auto level_name(const Log_level level) noexcept -> std::string_view
+   {
+      if (level == Log_level::warning) return "warning"_sv;
+      if (level == Log_level::error) return "error"_sv;
+
+      return "info"_sv;
+   }
+
+   static auto level_prefix(const Log_level level) noexcept -> std::string_view
+   {
+      if (level == Log_level::warning) return "Warning: "_sv;
+      if (level == Log_level::error) return "Error: "_sv;
+
+      return "Info: "_sv;
+   }
+
+   auto thread_ring() -> Message_ring&
+   {
+      thread_local const auto ring = [this] {
+         auto ring = std::make_shared<Message_ring>();
+
+         std::lock_guard<std::mutex> lock{_rings_mutex};
+         _rings.push_back(ring);
+
+         return ring;
+      }();
+
+      return *ring;
+   }
+
+   std::atomic<Log_level> _min_level{Log_level::info};
+   std::atomic<Log_format> _format{Log_format::text};
+
+   std::atomic_uint64_t _next_sequence{0};
+   std::atomic_uint64_t _written{0};
+
+   std::mutex _rings_mutex;
+   std::vector<std::shared_ptr<Message_ring>> _rings;
+
+   std::mutex _write_mutex;
+   std::vector<Message> _pending;
+   std::string _buffer;
+
+   std::mutex _mutex;
+   std::condition_variable _wake;
+   std::condition_variable _written_cv;
+   std::atomic_bool _running{false};
+   std::thread _thread;
+};
+}
+
+void start(const Log_level min_level, const Log_format format)
+{
+   Log_writer::get().start(min_level, format);
+}
+
+void stop() noexcept
+{
+   Log_writer::get().stop();
+}
+
+void flush() noexcept
+{
+   Log_writer::get().flush();
+}
+
+namespace detail {
+
+void push(const Log_level level, std::string message) noexcept
+{
+   Log_writer::get().push({0, level, false, std::move(message)});
+}
+
+void push_raw(std::string line) noexcept
+{
+   Log_writer::get().push({0, Log_level::info, true, std::move(line)});
+}
+
+bool enabled(const Log_level level) noexcept
+{
+   return Log_writer::get().enabled(level);
+}
+}
+}
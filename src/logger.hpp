@@ -0,0 +1,105 @@
+#pragma once
+
+#include <exception>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+enum class Log_level { info, warning, error };
+
+enum class Log_format { text, json };
+
+//! \brief Asynchronous logging to standard output.
+//!
+//! Messages are formatted on the calling thread and placed in a buffer owned by that
+//! thread, a background thread collects them and does the actual writing. Logging a
+//! message never touches the console or takes a lock shared with other logging threads.
+//!
+//! Messages from one thread are written in the order that thread logged them. Messages
+//! from different threads that are collected together are written in the order they
+//! were logged in, but one that is still being handed over, such as while its thread's
+//! buffer is full, can be written after messages other threads logged later.
+namespace logger {
+
+//! \brief Starts the background writer. Messages logged before this are kept and
+//! written once it is running.
+void start(const Log_level min_level, const Log_format format);
+
+//! \brief Writes out every message logged so far and stops the background writer.
+void stop() noexcept;
+
+//! \brief Blocks until every message logged so far has been written.
+void flush() noexcept;
+
+namespace detail {
+
+void push(const Log_level level, std::string message) noexcept;
+
+void push_raw(std::string line) noexcept;
+
+bool enabled(const Log_level level) noexcept;
+
+template<typename Arg>
+inline void append(std::string& message, const Arg& arg)
+{
+   if constexpr (std::is_convertible_v<const Arg&, std::string_view>) {
+      message += std::string_view{arg};
+   }
+   else if constexpr (std::is_same_v<Arg, char>) {
+      message += arg;
+   }
+   else if constexpr (std::is_arithmetic_v<Arg>) {
+      message += std::to_string(arg);
+   }
+   else {
+      std::ostringstream stream;
+      stream << arg;
+
+      message += stream.str();
+   }
+}
+
+template<typename... Args>
+inline void log(const Log_level level, const Args&... args) noexcept
+{
+   if (!enabled(level)) return;
+
+   try {
+      std::string message;
+
+      (append(message, args), ...);
+
+      push(level, std::move(message));
+   }
+   catch (std::exception&) {
+   }
+}
+}
+
+template<typename... Args>
+inline void info(const Args&... args) noexcept
+{
+   detail::log(Log_level::info, args...);
+}
+
+template<typename... Args>
+inline void warning(const Args&... args) noexcept
+{
+   detail::log(Log_level::warning, args...);
+}
+
+template<typename... Args>
+inline void error(const Args&... args) noexcept
+{
+   detail::log(Log_level::error, args...);
+}
+
+//! \brief Writes a line exactly as given, used to pass on output that is already
+//! formatted such as a worker process's log.
+inline void relay(std::string line) noexcept
+{
+   detail::push_raw(std::move(line));
+}
+}
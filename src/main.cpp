@@ -1,21 +1,38 @@
 
 #include "app_options.hpp"
 #include "assemble_chunks.hpp"
+#include "chunk_diff.hpp"
 #include "chunk_handlers.hpp"
+#include "chunk_index.hpp"
+#include "chunk_processor.hpp"
+#include "config_tree.hpp"
+#include "content_hash.hpp"
+#include "coordinator.hpp"
+#include "error_report.hpp"
 #include "explode_chunk.hpp"
+#include "extract_cache.hpp"
 #include "file_saver.hpp"
+#include "input_discovery.hpp"
+#include "input_format.hpp"
+#include "journal.hpp"
+#include "logger.hpp"
 #include "mapped_file.hpp"
-#include "synced_cout.hpp"
+#include "patch_chunk.hpp"
+#include "type_pun.hpp"
 #include "ucfb_reader.hpp"
+#include "verify_manifest.hpp"
 
-#include "tbb/parallel_for_each.h"
-
+#include <array>
+#include <chrono>
 #include <cstddef>
 #include <exception>
 #include <filesystem>
 #include <functional>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <Windows.h>
 
@@ -26,10 +43,22 @@ const auto usage = R"(Usage: swbf-unmunge <options>
 
 Options:)"s;
 
-void extract_file(const App_options& options, fs::path path) noexcept
+// Processors return the files they output, or nothing if the input was not fully
+// processed.
+using Processor_result = std::optional<std::vector<std::string>>;
+
+Processor_result finished_outputs(const File_saver& file_saver)
+{
+   if (!file_saver.complete()) return std::nullopt;
+
+   return file_saver.output_files();
+}
+
+auto extract_file(const App_options& options, fs::path path) noexcept -> Processor_result
 {
    try {
       Mapped_file file{path};
+      error_report::Source_scope source_scope{path.u8string(), file.bytes()};
       File_saver file_saver{fs::path{path}.replace_extension("") += '/',
                             options.verbose()};
       msh::Builders_map msh_builders;
@@ -40,15 +69,81 @@ void extract_file(const App_options& options, fs::path path) noexcept
          throw std::runtime_error{"Root chunk is now ucfb as expected."};
       }
 
-      handle_ucfb(static_cast<Ucfb_reader>(root_reader), options, file_saver);
+      const auto input_format = detect_input_format(root_reader, options);
+
+      if (options.verbose()) {
+         logger::info("Detected \""s, to_string(input_format), "\" as the format of \""s,
+                      path.string(), '\"');
+      }
+
+      std::optional<Extract_cache> cache;
+
+      if (!options.cache_directory().empty()) {
+         cache.emplace(options.cache_directory(), path, options, input_format);
+      }
+
+      handle_ucfb(static_cast<Ucfb_reader>(root_reader), options, input_format,
+                  file_saver, cache ? &cache.value() : nullptr);
+
+      if (cache) cache->save();
+
+      return finished_outputs(file_saver);
+   }
+   catch (std::exception& e) {
+      error_report::add_error(path.u8string(), ""s, "extract_file"_sv, e.what());
+
+      logger::error("Exception occured while processing file.\n   File: "s, path.string(),
+                    "\n   Message: "s, e.what());
+   }
+
+   return std::nullopt;
+}
+
+auto verify_file(const App_options& options, fs::path path) noexcept -> Processor_result
+{
+   try {
+      Mapped_file file{path};
+      error_report::Source_scope source_scope{path.u8string(), file.bytes()};
+      const auto output_directory = fs::path{path}.replace_extension("");
+      auto file_saver = File_saver::create_discarding(fs::path{output_directory} += '/',
+                                                      options.verbose());
+
+      Ucfb_reader root_reader{file.bytes()};
+
+      if (root_reader.magic_number() != "ucfb"_mn) {
+         throw std::runtime_error{"Root chunk is not ucfb as expected."};
+      }
+
+      const auto input_format = detect_input_format(root_reader, options);
+
+      handle_ucfb(root_reader, options, input_format, file_saver);
+
+      const auto manifest_path = fs::path{path}.replace_extension(".checksums"s);
+
+      save_file_atomically(manifest_path,
+                           create_verify_manifest(root_reader, output_directory,
+                                                  file_saver.output_checksums()));
+
+      if (!file_saver.complete()) return std::nullopt;
+
+      if (options.verbose()) {
+         logger::info("Verified \""s, path.string(), "\" as \""s,
+                      to_string(input_format), '\"');
+      }
+
+      return std::vector<std::string>{manifest_path.u8string()};
    }
    catch (std::exception& e) {
-      synced_cout::print("Error: Exception occured while processing file.\n   File: "s,
-                         path.string(), '\n', "   Message: "s, e.what(), '\n');
+      error_report::add_error(path.u8string(), ""s, "verify_file"_sv, e.what());
+
+      logger::error("Exception occured while verifying file.\n   File: "s, path.string(),
+                    "\n   Message: "s, e.what());
    }
+
+   return std::nullopt;
 }
 
-void explode_file(const App_options& options, fs::path path) noexcept
+auto explode_file(const App_options& options, fs::path path) noexcept -> Processor_result
 {
    try {
       Mapped_file file{path};
@@ -56,40 +151,438 @@ void explode_file(const App_options& options, fs::path path) noexcept
                             options.verbose()};
 
       Ucfb_reader root_reader{file.bytes()};
+      Chunk_classifier classifier;
+
+      explode_chunk(root_reader, file_saver, classifier);
+
+      if (options.verbose()) {
+         const auto stats = classifier.stats();
+
+         logger::info("Exploded \""s, path.string(), "\", scanned "s,
+                      stats.scanned_chunks, " chunks for children and skipped "s,
+                      stats.skipped_chunks, " chunks ("s, stats.skipped_bytes,
+                      " bytes), "s, stats.wasted_bytes,
+                      " bytes were scanned in chunks without children"s);
+      }
 
-      explode_chunk(root_reader, file_saver);
+      return finished_outputs(file_saver);
    }
    catch (std::exception& e) {
-      synced_cout::print("Error: Exception occured while processing file.\n   File: "s,
-                         path.string(), '\n', "   Message: "s, e.what(), '\n');
+      error_report::add_error(path.u8string(), ""s, "explode_file"_sv, e.what());
+
+      logger::error("Exception occured while processing file.\n   File: "s, path.string(),
+                    "\n   Message: "s, e.what());
    }
+
+   return std::nullopt;
 }
 
-void assemble_directory(const App_options& options, fs::path path) noexcept
+auto assemble_directory(const App_options& options, fs::path path) noexcept
+   -> Processor_result
 {
    try {
       File_saver file_saver{fs::path{path}.replace_extension("") /= "../",
                             options.verbose()};
 
       assemble_chunks(path, file_saver);
+
+      return finished_outputs(file_saver);
+   }
+   catch (std::exception& e) {
+      error_report::add_error(path.u8string(), ""s, "assemble_directory"_sv, e.what());
+
+      logger::error("Exception occured while assembling directory.\n   Directory: "s,
+                    path.string(), "\n   Message: "s, e.what());
+   }
+
+   return std::nullopt;
+}
+
+auto patch_file(const App_options& options, fs::path path) noexcept -> Processor_result
+{
+   try {
+      if (options.patch_chunk().empty() || options.patch_file().empty()) {
+         throw std::invalid_argument{
+            "The 'patch' mode needs both '-patchchunk' and '-patchfile'."};
+      }
+
+      const auto start = std::chrono::steady_clock::now();
+
+      patch_chunk(path, options.patch_chunk(), fs::u8path(options.patch_file()));
+
+      if (options.verbose()) {
+         const std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - start;
+
+         logger::info("Patched \""s, path.string(), "\" in "s, time.count() * 1000.0,
+                      "ms"s);
+      }
+
+      return std::vector<std::string>{path.u8string()};
+   }
+   catch (std::exception& e) {
+      error_report::add_error(path.u8string(), ""s, "patch_file"_sv, e.what());
+
+      logger::error("Exception occured while patching file.\n   File: "s, path.string(),
+                    "\n   Message: "s, e.what());
+   }
+
+   return std::nullopt;
+}
+
+// Query results are the mode's output rather than log messages, so they are written
+// straight to stdout after anything already logged, whatever the log level or format.
+void print_result(const std::string& result)
+{
+   logger::flush();
+
+   std::cout << result << '\n';
+   std::cout.flush();
+}
+
+void query_config_chunks(Ucfb_reader parent, const App_options& options,
+                         const fs::path& path)
+{
+   while (parent) {
+      auto child = parent.read_child();
+
+      if (child.magic_number() == "lvl_"_mn) {
+         child.consume(4); // lvl name hash
+         child.consume(4); // lvl size left
+
+         query_config_chunks(child, options, path);
+
+         continue;
+      }
+
+      if (!is_config_chunk(child.magic_number())) continue;
+
+      try {
+         const Config_tree tree{child, config_strings_are_hashed(child.magic_number())};
+
+         for (const auto& query : options.config_queries()) {
+            for (const auto node : tree.query(query)) {
+               print_result(path.string() + ' ' +
+                            view_pod_as_string(child.magic_number()) + ' ' +
+                            std::to_string(tree.name_hash()) + ' ' + query + ": "s +
+                            format_config_node(*node));
+            }
+         }
+      }
+      catch (std::exception& e) {
+         error_report::add_chunk_error(child, "query_configs"_sv, e.what());
+
+         logger::error("Exception occured while querying config.\n   File: "s,
+                       path.string(), "\n   Message: "s, e.what());
+      }
+   }
+}
+
+auto query_configs(const App_options& options, fs::path path) noexcept
+   -> Processor_result
+{
+   try {
+      Mapped_file file{path};
+      error_report::Source_scope source_scope{path.u8string(), file.bytes()};
+
+      Ucfb_reader root_reader{file.bytes()};
+
+      if (root_reader.magic_number() != "ucfb"_mn) {
+         throw std::runtime_error{"Root chunk is not ucfb as expected."};
+      }
+
+      query_config_chunks(root_reader, options, path);
+
+      return std::vector<std::string>{};
    }
    catch (std::exception& e) {
-      synced_cout::print(
-         "Error: Exception occured while assembling directory.\n   Directory: "s,
-         path.string(), '\n', "   Message: "s, e.what(), '\n');
+      error_report::add_error(path.u8string(), ""s, "query_configs"_sv, e.what());
+
+      logger::error("Exception occured while querying file.\n   File: "s, path.string(),
+                    "\n   Message: "s, e.what());
    }
+
+   return std::nullopt;
 }
 
-auto get_file_processor(const Tool_mode mode)
-   -> std::function<void(const App_options&, fs::path)>
+void diff_files(const App_options& options) noexcept
+{
+   const auto& inputs = options.input_files();
+
+   if (inputs.size() != 2) {
+      logger::error("'diff' takes exactly two input files, the old and the new."s);
+
+      return;
+   }
+
+   try {
+      Mapped_file old_file{fs::u8path(inputs[0])};
+      Mapped_file new_file{fs::u8path(inputs[1])};
+
+      const auto changes =
+         diff_chunks(Ucfb_reader{old_file.bytes()}, Ucfb_reader{new_file.bytes()});
+
+      std::string report;
+      std::array<std::size_t, 3> counts{};
+
+      for (const auto& change : changes) {
+         ++counts[static_cast<std::size_t>(change.kind)];
+
+         report += "\n   "_sv;
+         report += to_string(change.kind);
+         report += ' ';
+         report += change.path;
+
+         if (!change.name.empty()) {
+            report += " \""_sv;
+            report += change.name;
+            report += '\"';
+         }
+
+         report += ' ';
+
+         if (change.kind == Chunk_change_kind::changed) {
+            report += std::to_string(change.old_size);
+            report += " -> "_sv;
+         }
+
+         report += std::to_string(change.kind == Chunk_change_kind::removed
+                                     ? change.old_size
+                                     : change.new_size);
+         report += " bytes"_sv;
+      }
+
+      print_result("Chunk differences from \""s + inputs[0] + "\" to \""s + inputs[1] +
+                   '\"' + report + "\n   "s + std::to_string(counts[0]) + " added, "s +
+                   std::to_string(counts[1]) + " removed, "s +
+                   std::to_string(counts[2]) + " changed"s);
+   }
+   catch (std::exception& e) {
+      error_report::add_error(inputs[1], ""s, "diff_files"_sv, e.what());
+
+      logger::error("Exception occured while comparing files.\n   Old File: "s, inputs[0],
+                    "\n   New File: "s, inputs[1], "\n   Message: "s, e.what());
+   }
+}
+
+void index_files(const App_options& options) noexcept
+{
+   try {
+      build_chunk_index(options.input_files(), fs::u8path(options.index_file()));
+   }
+   catch (std::exception& e) {
+      error_report::add_error(options.index_file(), ""s, "index_files"_sv, e.what());
+
+      logger::error("Exception occured while saving index.\n   File: "s,
+                    options.index_file(), "\n   Message: "s, e.what());
+   }
+}
+
+void extract_index_match(const App_options& options, const Index_match& match)
+{
+   const auto path = fs::u8path(match.input_file);
+
+   Mapped_file file{path};
+   error_report::Source_scope source_scope{match.input_file, file.bytes()};
+   File_saver file_saver{fs::path{path}.replace_extension("") += '/', options.verbose()};
+
+   const Ucfb_reader root{file.bytes()};
+   Ucfb_reader parent{file.bytes().subspan(match.parent_offset)};
+
+   if (parent.magic_number() == "lvl_"_mn) {
+      parent.consume(4); // lvl name hash
+      parent.consume(4); // lvl size left
+   }
+
+   // Handlers that read ahead expect the parent to be left just past the chunk.
+   std::optional<Ucfb_reader> chunk;
+
+   while (parent && !chunk) {
+      const auto child = parent.read_child();
+      const auto offset = static_cast<std::size_t>(child.bytes().data() -
+                                                   file.bytes().data()) - 8;
+
+      if (offset == match.offset) chunk.emplace(child);
+   }
+
+   const auto chunk_hash = [](const Ucfb_reader& reader) {
+      return content_hash(reader.bytes(),
+                          static_cast<std::uint32_t>(reader.magic_number()));
+   };
+
+   if (!chunk || chunk_hash(*chunk) != match.content_hash) {
+      throw std::runtime_error{"The file has changed since it was indexed."};
+   }
+
+   msh::Builders_map msh_builders;
+
+   process_chunk(*chunk, parent, options, detect_input_format(root, options), file_saver,
+                 msh_builders);
+
+   msh::save_all(file_saver, msh_builders, options.output_game_version(),
+                 match.input_file);
+}
+
+void query_index(const App_options& options) noexcept
+{
+   try {
+      const Chunk_index index{fs::u8path(options.index_file())};
+
+      for (const auto& query : options.queries()) {
+         const auto matches = index.find(query);
+
+         if (matches.empty()) logger::warning("No chunks found for \""s, query, '\"');
+
+         for (const auto& match : matches) {
+            const std::string magic_number{view_pod_as_string(match.magic_number)};
+
+            print_result("Found \""s + query + "\" in \""s + match.input_file +
+                         "\"\n   Chunk: "s + magic_number + "\n   Name: "s +
+                         match.name + "\n   Offset: "s + std::to_string(match.offset) +
+                         "\n   Size: "s + std::to_string(match.size) + "\n   Hash: "s +
+                         content_hash_string(match.content_hash));
+
+            if (!options.query_extract()) continue;
+
+            try {
+               extract_index_match(options, match);
+            }
+            catch (std::exception& e) {
+               error_report::add_error(match.input_file, ""s, "query_index"_sv, e.what());
+
+               logger::error("Exception occured while extracting chunk.\n   File: "s,
+                             match.input_file, "\n   Offset: "s, match.offset,
+                             "\n   Message: "s, e.what());
+            }
+         }
+      }
+   }
+   catch (std::exception& e) {
+      error_report::add_error(options.index_file(), ""s, "query_index"_sv, e.what());
+
+      logger::error("Exception occured while reading index.\n   File: "s,
+                    options.index_file(), "\n   Message: "s, e.what());
+   }
+}
+
+// Modes that process each input on its own, so they can be spread over worker processes.
+bool processes_inputs_separately(const Tool_mode mode) noexcept
+{
+   return mode != Tool_mode::diff && mode != Tool_mode::index && mode != Tool_mode::query;
+}
+
+using File_processor = std::function<Processor_result(const App_options&, fs::path)>;
+
+auto get_file_processor(const Tool_mode mode) -> File_processor
 {
    if (mode == Tool_mode::extract) return extract_file;
    if (mode == Tool_mode::explode) return explode_file;
    if (mode == Tool_mode::assemble) return assemble_directory;
+   if (mode == Tool_mode::verify) return verify_file;
+   if (mode == Tool_mode::config) return query_configs;
+   if (mode == Tool_mode::patch) return patch_file;
 
    throw std::invalid_argument{""};
 }
 
+bool process_input(const App_options& options, const File_processor& processor,
+                   const std::optional<Journal>& journal,
+                   const std::string& file) noexcept
+{
+   try {
+      if (journal && options.resume() && journal->finished(file)) {
+         if (options.verbose()) {
+            logger::info("Skipping finished file \""s, file, '\"');
+         }
+
+         return true;
+      }
+
+      const auto outputs = processor(options, file);
+
+      if (journal && outputs) journal->record(file, *outputs);
+
+      return outputs.has_value();
+   }
+   catch (std::exception& e) {
+      error_report::add_error(file, ""s, "journal"_sv, e.what());
+
+      logger::error("Exception occured while journaling file.\n   File: "s, file,
+                    "\n   Message: "s, e.what());
+   }
+
+   return false;
+}
+
+void run_worker(const App_options& options, const File_processor& processor,
+                const std::optional<Journal>& journal)
+{
+   std::string file;
+
+   while (std::getline(std::cin, file)) {
+      const auto first_error = error_report::count();
+      const bool succeeded = process_input(options, processor, journal, file);
+
+      for (const auto& error : error_report::records_since(first_error)) {
+         logger::relay(worker_error(error));
+      }
+
+      logger::relay(worker_reply(succeeded, file));
+      logger::flush();
+   }
+}
+
+void process_inputs(const App_options& app_options)
+{
+   if (app_options.tool_mode() == Tool_mode::diff) return diff_files(app_options);
+   if (app_options.tool_mode() == Tool_mode::index) return index_files(app_options);
+
+   CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+   if (app_options.tool_mode() == Tool_mode::query) {
+      query_index(app_options);
+      CoUninitialize();
+
+      return;
+   }
+
+   const auto processor = get_file_processor(app_options.tool_mode());
+
+   std::optional<Journal> journal;
+
+   if (!app_options.journal_directory().empty()) {
+      journal.emplace(fs::u8path(app_options.journal_directory()), app_options);
+   }
+
+   if (app_options.worker()) {
+      run_worker(app_options, processor, journal);
+   }
+   else {
+      for_each_input(app_options.input_files(),
+                     app_options.tool_mode() == Tool_mode::assemble,
+                     [&](const std::string& file) {
+                        process_input(app_options, processor, journal, file);
+                     });
+   }
+
+   CoUninitialize();
+}
+
+void finish_error_report(const App_options& app_options) noexcept
+{
+   error_report::print_summary();
+
+   if (app_options.error_report_file().empty()) return;
+
+   try {
+      error_report::save(fs::u8path(app_options.error_report_file()));
+   }
+   catch (std::exception& e) {
+      logger::error("Exception occured while saving error report.\n   Message: "s,
+                    e.what());
+   }
+}
+
 int main(int argc, char* argv[])
 {
    std::ios_base::sync_with_stdio(false);
@@ -104,21 +597,33 @@ int main(int argc, char* argv[])
 
    const App_options app_options{argc, argv};
 
-   const auto& input_files = app_options.input_files();
+   const bool needs_inputs =
+      !app_options.worker() && app_options.tool_mode() != Tool_mode::query;
 
-   if (input_files.empty()) {
+   if (app_options.input_files().empty() && needs_inputs) {
       std::cout << "Error: No input file specified.\n"s;
 
       return 0;
    }
 
-   CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+   logger::start(app_options.log_level(), app_options.log_format());
 
-   const auto processor = get_file_processor(app_options.tool_mode());
+   const bool use_workers = app_options.jobs() > 1 && !app_options.worker() &&
+                            processes_inputs_separately(app_options.tool_mode());
 
-   tbb::parallel_for_each(input_files, [&app_options, &processor](const auto& file) {
-      processor(app_options, file);
-   });
+   if (use_workers) {
+      run_coordinator(app_options);
+   }
+   else {
+      process_inputs(app_options);
+   }
 
-   CoUninitialize();
+   // Workers pass their errors on to the coordinator, which reports them.
+   if (!app_options.worker()) finish_error_report(app_options);
+
+   logger::stop();
+
+   const bool failed = error_report::count() > app_options.max_errors();
+
+   return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
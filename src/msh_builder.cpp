@@ -2,15 +2,21 @@
 #include "msh_builder.hpp"
 #include "bit_flags.hpp"
 #include "cloth_converter.hpp"
+#include "error_report.hpp"
+#include "logger.hpp"
 #include "magic_number.hpp"
 #include "string_helpers.hpp"
-#include "synced_cout.hpp"
-#include "ucfb_builder.hpp"
+#include "ucfb_writer.hpp"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
 #include "tbb/parallel_for_each.h"
+#include "tbb/task_arena.h"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <optional>
 #include <stdexcept>
@@ -79,19 +85,6 @@ auto create_bone_index(
    return bone_indices;
 }
 
-template<typename Type>
-std::vector<Type> downgrade_concurrent_vector(const tbb::concurrent_vector<Type>& from)
-{
-   std::vector<Type> to;
-   to.reserve(from.size());
-
-   for (const auto& item : from) {
-      to.push_back(item);
-   }
-
-   return to;
-}
-
 const Bone& find_root_bone(const std::vector<Bone>& bones)
 {
    const auto root = std::find_if(std::cbegin(bones), std::cend(bones),
@@ -143,47 +136,91 @@ auto sort_sections(std::vector<Modl_section>& sections)
    return create_bone_index(old_index_map, sections);
 }
 
-void reverse_pretransformed(std::vector<Model>& meshes, const std::vector<Bone>& bones)
+// The index of each bone's parent, or the bone count for bones without one.
+auto find_parent_indices(const std::vector<Bone>& bones) -> std::vector<std::size_t>
 {
-   for (auto& mesh : meshes) {
-      if (!mesh.pretransformed || mesh.skin.empty()) continue;
+   std::unordered_map<std::string_view, std::size_t> bone_indices;
+   bone_indices.reserve(bones.size());
 
-      if (mesh.skin.size() != mesh.positions.size() ||
-          mesh.skin.size() != mesh.normals.size()) {
-         throw std::runtime_error{
-            "Count of segment's skin entries and vertex entries does not match"};
-      }
+   for (std::size_t i = 0; i < bones.size(); ++i) {
+      bone_indices.emplace(bones[i].name, i);
+   }
 
-      for (std::size_t vertex = 0; vertex < mesh.skin.size(); ++vertex) {
-         glm::vec3 weighted_position;
-         glm::vec3 weighted_normal;
+   std::vector<std::size_t> parent_indices;
+   parent_indices.reserve(bones.size());
 
-         for (auto i = 0; i < 3; ++i) {
-            auto position = mesh.positions[vertex];
-            auto normal = mesh.normals[vertex];
+   for (const auto& bone : bones) {
+      const auto parent = bone_indices.find(bone.parent);
 
-            const auto bone_index = mesh.bone_map.at(mesh.skin[vertex].bones[i]);
-            auto bone = bones.begin() + bone_index;
+      parent_indices.push_back(parent != bone_indices.cend() ? parent->second
+                                                             : bones.size());
+   }
 
-            while (bone < std::end(bones)) {
-               position = position * glm::inverse(bone->rotation);
-               normal = normal * glm::inverse(bone->rotation);
+   return parent_indices;
+}
 
-               position += bone->position;
+void reverse_pretransformed(Model& mesh, const std::vector<Bone>& bones,
+                            const std::vector<std::size_t>& parent_indices,
+                            const std::vector<glm::quat>& inverse_rotations)
+{
+   if (mesh.skin.size() != mesh.positions.size() ||
+       mesh.skin.size() != mesh.normals.size()) {
+      throw std::runtime_error{
+         "Count of segment's skin entries and vertex entries does not match"};
+   }
 
-               bone = std::find_if(
-                  std::begin(bones), std::end(bones),
-                  [bone](const Bone& other) { return (other.name == bone->parent); });
-            }
+   const auto reverse_vertex = [&](const std::size_t vertex) {
+      glm::vec3 weighted_position;
+      glm::vec3 weighted_normal;
+
+      for (auto i = 0; i < 3; ++i) {
+         auto position = mesh.positions[vertex];
+         auto normal = mesh.normals[vertex];
+
+         std::size_t bone = mesh.bone_map.at(mesh.skin[vertex].bones[i]);
+
+         while (bone < bones.size()) {
+            position = position * inverse_rotations[bone];
+            normal = normal * inverse_rotations[bone];
 
-            weighted_position += (position * mesh.skin[vertex].weights[i]);
-            weighted_normal += (normal * mesh.skin[vertex].weights[i]);
+            position += bones[bone].position;
+
+            bone = parent_indices[bone];
          }
 
-         mesh.positions[vertex] = weighted_position;
-         mesh.normals[vertex] = glm::normalize(weighted_normal);
+         weighted_position += (position * mesh.skin[vertex].weights[i]);
+         weighted_normal += (normal * mesh.skin[vertex].weights[i]);
       }
+
+      mesh.positions[vertex] = weighted_position;
+      mesh.normals[vertex] = glm::normalize(weighted_normal);
+   };
+
+   tbb::parallel_for(tbb::blocked_range<std::size_t>{0, mesh.skin.size()},
+                     [&](const tbb::blocked_range<std::size_t>& range) {
+                        for (auto vertex = range.begin(); vertex != range.end();
+                             ++vertex) {
+                           reverse_vertex(vertex);
+                        }
+                     });
+}
+
+void reverse_pretransformed(std::vector<Model>& meshes, const std::vector<Bone>& bones)
+{
+   const auto parent_indices = find_parent_indices(bones);
+
+   std::vector<glm::quat> inverse_rotations;
+   inverse_rotations.reserve(bones.size());
+
+   for (const auto& bone : bones) {
+      inverse_rotations.push_back(glm::inverse(bone.rotation));
    }
+
+   tbb::parallel_for_each(meshes, [&](Model& mesh) {
+      if (!mesh.pretransformed || mesh.skin.empty()) return;
+
+      reverse_pretransformed(mesh, bones, parent_indices, inverse_rotations);
+   });
 }
 
 std::size_t count_strips_indices(const std::vector<std::vector<std::uint16_t>>& strips)
@@ -278,7 +315,7 @@ Modl_section create_section_from(const Bone& bone, std::string_view, std::uint32
    return section;
 }
 
-Modl_section create_section_from(const Model& model, std::string_view root_name,
+Modl_section create_section_from(Model model, std::string_view root_name,
                                  std::uint32_t index)
 {
    Modl_section section;
@@ -300,26 +337,26 @@ Modl_section create_section_from(const Model& model, std::string_view root_name,
       break;
    }
 
-   section.parent = model.parent.value_or(std::string{root_name});
+   section.parent = model.parent.value_or(root_name);
 
    section.rotation = model.rotation;
    section.translation = model.position;
 
-   section.material = model.material;
+   section.material = std::move(model.material);
    fixup_texture_names(*section.material);
 
    section.strips = strips_to_msh_fmt(model.strips);
-   section.positions = model.positions;
-   section.normals = model.normals;
+   section.positions = std::move(model.positions);
+   section.normals = std::move(model.normals);
 
    if (!model.colours.empty()) {
-      section.colours = model.colours;
+      section.colours = std::move(model.colours);
    }
    if (!model.texture_coords.empty()) {
-      section.texture_coords = model.texture_coords;
+      section.texture_coords = std::move(model.texture_coords);
    }
    if (!model.skin.empty()) {
-      section.skin = model.skin;
+      section.skin = std::move(model.skin);
       section.type = Model_type::skin;
    }
    if (!model.bone_map.empty()) {
@@ -386,25 +423,31 @@ std::vector<Modl_section> create_modl_sections(
 {
    reverse_pretransformed(models, bones);
 
-   std::vector<Modl_section> sections;
-   sections.reserve(bones.size() + models.size());
+   std::vector<Modl_section> sections(bones.size() + models.size() +
+                                      collision_meshes.size() +
+                                      collision_primitives.size() + cloths.size());
 
    const auto root_name = find_root_bone(bones).name;
-   std::uint32_t model_index = 1;
+   std::size_t first_section = 0;
+
+   const auto create_sections = [&sections, &first_section, root_name](auto& items) {
+      const auto first = first_section;
+
+      tbb::parallel_for(std::size_t{0}, items.size(), [&, first](const std::size_t i) {
+         const auto model_index = static_cast<std::uint32_t>(first + i + 1);
 
-   const auto create_section = [&sections, &model_index, &root_name](auto& item) {
-      sections.emplace_back(create_section_from(item, root_name, model_index));
+         sections[first + i] =
+            create_section_from(std::move(items[i]), root_name, model_index);
+      });
 
-      model_index += 1;
+      first_section += items.size();
    };
 
-   std::for_each(std::begin(bones), std::end(bones), create_section);
-   std::for_each(std::begin(models), std::end(models), create_section);
-   std::for_each(std::begin(collision_meshes), std::end(collision_meshes),
-                 create_section);
-   std::for_each(std::begin(collision_primitives), std::end(collision_primitives),
-                 create_section);
-   std::for_each(std::begin(cloths), std::end(cloths), create_section);
+   create_sections(bones);
+   create_sections(models);
+   create_sections(collision_meshes);
+   create_sections(collision_primitives);
+   create_sections(cloths);
 
    const auto bone_index = sort_sections(sections);
 
@@ -417,299 +460,324 @@ std::vector<Modl_section> create_modl_sections(
    return sections;
 }
 
-template<Magic_number magic_number>
-Ucfb_builder create_pos_chunk(const std::vector<glm::vec3>& positions)
+template<typename Type>
+std::size_t array_size(const std::optional<std::vector<Type>>& array) noexcept
+{
+   return array ? array->size() * sizeof(Type) : 0;
+}
+
+// A guess at the size of a section's MODL chunk, large enough that the buffer is
+// rarely grown while it is being written.
+std::size_t estimate_msh_size(const Modl_section& section) noexcept
 {
-   Ucfb_builder pos{magic_number};
-   pos.write(static_cast<std::uint32_t>(positions.size()));
+   constexpr std::size_t section_overhead = 512;
+   constexpr std::size_t skin_entry_size = 32;
+
+   std::size_t size = section_overhead;
+
+   size += array_size(section.strips) + array_size(section.positions) +
+           array_size(section.normals) + array_size(section.texture_coords) +
+           array_size(section.bone_map);
+
+   if (section.colours) size += section.colours->size() * sizeof(std::uint32_t);
+   if (section.skin) size += section.skin->size() * skin_entry_size;
+
+   if (section.cloth) {
+      const auto& cloth = *section.cloth;
 
-   for (const auto& v : positions) {
-      pos.write_multiple(v.x, v.y, v.z);
+      size += cloth.positions.size() * sizeof(glm::vec3) +
+              cloth.texture_coords.size() * sizeof(glm::vec2) +
+              cloth.indices.size() * sizeof(glm::uvec3);
    }
 
-   return pos;
+   return size;
 }
 
-template<Magic_number magic_number>
-Ucfb_builder create_uv_chunk(const std::vector<glm::vec2>& texture_coords)
+std::size_t estimate_msh_size(const std::vector<Modl_section>& sections) noexcept
 {
-   Ucfb_builder uvl{magic_number};
-   uvl.write(static_cast<std::uint32_t>(texture_coords.size()));
+   constexpr std::size_t header_overhead = 512;
 
-   for (const auto& uv : texture_coords) {
-      uvl.write_multiple(uv.x, uv.y);
-   }
+   std::size_t size = header_overhead;
+
+   for (const auto& section : sections) size += estimate_msh_size(section);
+
+   return size;
+}
+
+// Arrays of these are copied into the file as they are, without any padding.
+static_assert(sizeof(glm::vec2) == 8 && sizeof(glm::vec3) == 12);
+static_assert(sizeof(glm::uvec3) == 12);
+static_assert(sizeof(std::array<std::uint16_t, 2>) == 4);
 
-   return uvl;
+template<Magic_number magic_number>
+void write_pos_chunk(Ucfb_writer& writer, const std::vector<glm::vec3>& positions)
+{
+   writer.open(magic_number);
+   writer.write_counted_array(positions);
+   writer.close();
 }
 
-Ucfb_builder create_wght_chunk(const std::vector<Skin_entry>& skin)
+template<Magic_number magic_number>
+void write_uv_chunk(Ucfb_writer& writer, const std::vector<glm::vec2>& texture_coords)
 {
-   Ucfb_builder wght{"WGHT"_mn};
-   wght.write(static_cast<std::uint32_t>(skin.size()));
+   writer.open(magic_number);
+   writer.write_counted_array(texture_coords);
+   writer.close();
+}
+
+void write_wght_chunk(Ucfb_writer& writer, const std::vector<Skin_entry>& skin)
+{
+   writer.open("WGHT"_mn);
+   writer.write(static_cast<std::uint32_t>(skin.size()));
 
    for (const auto& entry : skin) {
       const auto bones = static_cast<glm::uvec3>(entry.bones);
       const auto& weights = entry.weights;
 
-      wght.write_multiple(bones.x, weights.x, bones.y, weights.y, bones.z, weights.z,
-                          0ui32, 0.0f);
+      writer.write_multiple(bones.x, weights.x, bones.y, weights.y, bones.z, weights.z,
+                            0ui32, 0.0f);
    }
 
-   return wght;
+   writer.close();
 }
 
-Ucfb_builder create_nrml_chunk(const std::vector<glm::vec3>& normals)
+void write_nrml_chunk(Ucfb_writer& writer, const std::vector<glm::vec3>& normals)
 {
-   Ucfb_builder nrml{"NRML"_mn};
-   nrml.write(static_cast<std::uint32_t>(normals.size()));
-
-   for (const auto& n : normals) {
-      nrml.write_multiple(n.x, n.y, n.z);
-   }
-
-   return nrml;
+   writer.open("NRML"_mn);
+   writer.write_counted_array(normals);
+   writer.close();
 }
 
-Ucfb_builder create_clrl_chunk(const std::vector<glm::vec4>& colours)
+void write_clrl_chunk(Ucfb_writer& writer, const std::vector<glm::vec4>& colours)
 {
-   Ucfb_builder clrl{"CLRL"_mn};
-   clrl.write(static_cast<std::uint32_t>(colours.size()));
+   writer.open("CLRL"_mn);
+   writer.write(static_cast<std::uint32_t>(colours.size()));
 
    for (const auto& c : colours) {
-      clrl.write(glm::packUnorm4x8(c));
+      writer.write(glm::packUnorm4x8(c));
    }
 
-   return clrl;
+   writer.close();
 }
 
-Ucfb_builder create_strp_chunk(const std::vector<std::uint16_t>& strips)
+void write_strp_chunk(Ucfb_writer& writer, const std::vector<std::uint16_t>& strips)
 {
-   Ucfb_builder strp{"STRP"_mn};
-   strp.write(static_cast<std::uint32_t>(strips.size()));
-
-   for (const auto indx : strips) {
-      strp.write(indx);
-   }
-
-   strp.pad_till_aligned();
-
-   return strp;
+   writer.open("STRP"_mn);
+   writer.write_counted_array(strips);
+   writer.pad_till_aligned(); // The padding is part of STRP's size.
+   writer.close();
 }
 
-Ucfb_builder create_segm_chunk(const Modl_section& section)
+void write_segm_chunk(Ucfb_writer& writer, const Modl_section& section)
 {
-   Ucfb_builder segm{"SEGM"_mn};
+   writer.open("SEGM"_mn);
 
-   segm.emplace_child("MATI"_mn).write(section.mat_index);
+   writer.open("MATI"_mn);
+   writer.write(section.mat_index);
+   writer.close();
 
-   if (section.positions) segm.add_child(create_pos_chunk<"POSL"_mn>(*section.positions));
-   if (section.skin) segm.add_child(create_wght_chunk(*section.skin));
-   if (section.normals) segm.add_child(create_nrml_chunk(*section.normals));
-   if (section.colours) segm.add_child(create_clrl_chunk(*section.colours));
+   if (section.positions) write_pos_chunk<"POSL"_mn>(writer, *section.positions);
+   if (section.skin) write_wght_chunk(writer, *section.skin);
+   if (section.normals) write_nrml_chunk(writer, *section.normals);
+   if (section.colours) write_clrl_chunk(writer, *section.colours);
    if (section.texture_coords)
-      segm.add_child(create_uv_chunk<"UV0L"_mn>(*section.texture_coords));
-   if (section.strips) segm.add_child(create_strp_chunk(*section.strips));
+      write_uv_chunk<"UV0L"_mn>(writer, *section.texture_coords);
+   if (section.strips) write_strp_chunk(writer, *section.strips);
 
-   return segm;
+   writer.close();
 }
 
-Ucfb_builder create_fidx_chunk(const std::vector<std::uint32_t>& fixed_points)
+void write_fidx_chunk(Ucfb_writer& writer, const std::vector<std::uint32_t>& fixed_points)
 {
-   Ucfb_builder fidx{"FIDX"_mn};
-   fidx.write(static_cast<std::uint32_t>(fixed_points.size()));
-
-   for (const auto& point : fixed_points) {
-      fidx.write(point);
-   }
-
-   return fidx;
+   writer.open("FIDX"_mn);
+   writer.write_counted_array(fixed_points);
+   writer.close();
 }
 
-Ucfb_builder create_fwgt_chunk(const std::vector<std::string>& fixed_weights)
+void write_fwgt_chunk(Ucfb_writer& writer, const std::vector<std::string>& fixed_weights)
 {
-   Ucfb_builder fwgt{"FWGT"_mn};
-   fwgt.write(static_cast<std::uint32_t>(fixed_weights.size()));
+   writer.open("FWGT"_mn);
+   writer.write(static_cast<std::uint32_t>(fixed_weights.size()));
 
    for (const auto& name : fixed_weights) {
-      fwgt.write(name, true, false);
+      writer.write(name, true, false);
    }
 
-   fwgt.pad_till_aligned();
-
-   return fwgt;
+   writer.pad_till_aligned(); // The padding is part of FWGT's size.
+   writer.close();
 }
 
-Ucfb_builder create_cmsh_chunk(const std::vector<glm::uvec3>& indices)
+void write_cmsh_chunk(Ucfb_writer& writer, const std::vector<glm::uvec3>& indices)
 {
-   Ucfb_builder cmsh{"CMSH"_mn};
-   cmsh.write(static_cast<std::uint32_t>(indices.size()));
-
-   for (const auto& i : indices) {
-      cmsh.write_multiple(i.x, i.y, i.z);
-   }
-
-   return cmsh;
+   writer.open("CMSH"_mn);
+   writer.write_counted_array(indices);
+   writer.close();
 }
 
 template<Magic_number magic_number>
-Ucfb_builder create_constraint_chunk(
-   const std::vector<std::array<std::uint16_t, 2>>& constraints)
+void write_constraint_chunk(Ucfb_writer& writer,
+                            const std::vector<std::array<std::uint16_t, 2>>& constraints)
 {
-   Ucfb_builder con{magic_number};
-   con.write(static_cast<std::uint32_t>(constraints.size()));
-
-   for (const auto& c : constraints) {
-      con.write_multiple(c[0], c[1]);
-   }
-
-   return con;
+   writer.open(magic_number);
+   writer.write_counted_array(constraints);
+   writer.close();
 }
 
-Ucfb_builder create_coll_chunk(const std::vector<Cloth_collision>& collision)
+void write_coll_chunk(Ucfb_writer& writer, const std::vector<Cloth_collision>& collision)
 {
-   Ucfb_builder coll{"COLL"_mn};
-   coll.write(static_cast<std::uint32_t>(collision.size()));
+   writer.open("COLL"_mn);
+   writer.write(static_cast<std::uint32_t>(collision.size()));
 
    std::size_t i = 0;
 
    for (const auto& node : collision) {
-      coll.write(node.parent + "cloth_"s + std::to_string(i), false, true);
-      coll.write(node.parent, true, false);
-      coll.write(node.type);
-      coll.write_multiple(node.size.x, node.size.y, node.size.z);
+      writer.write(node.parent + "cloth_"s + std::to_string(i), false, true);
+      writer.write(node.parent, true, false);
+      writer.write(node.type);
+      writer.write_multiple(node.size.x, node.size.y, node.size.z);
 
       ++i;
    }
 
-   return coll;
+   writer.close();
 }
 
-Ucfb_builder create_clth_chunk(const Cloth& cloth_info)
+void write_clth_chunk(Ucfb_writer& writer, const Cloth& cloth_info)
 {
-   Ucfb_builder clth{"CLTH"_mn};
-
-   clth.emplace_child("CTEX"_mn).write(cloth_info.texture_name);
-
-   clth.add_child(create_pos_chunk<"CPOS"_mn>(cloth_info.positions));
-   clth.add_child(create_uv_chunk<"CUV0"_mn>(cloth_info.texture_coords));
-   clth.add_child(create_fidx_chunk(cloth_info.fixed_points));
-   clth.add_child(create_fwgt_chunk(cloth_info.fixed_weights));
-   clth.add_child(create_cmsh_chunk(cloth_info.indices));
-   clth.add_child(create_constraint_chunk<"SPRS"_mn>(cloth_info.stretch_constraints));
-   clth.add_child(create_constraint_chunk<"CPRS"_mn>(cloth_info.cross_constraints));
-   clth.add_child(create_constraint_chunk<"BPRS"_mn>(cloth_info.bend_constraints));
-   clth.add_child(create_coll_chunk(cloth_info.collision));
-
-   return clth;
+   writer.open("CLTH"_mn);
+
+   writer.open("CTEX"_mn);
+   writer.write(cloth_info.texture_name);
+   writer.close();
+
+   write_pos_chunk<"CPOS"_mn>(writer, cloth_info.positions);
+   write_uv_chunk<"CUV0"_mn>(writer, cloth_info.texture_coords);
+   write_fidx_chunk(writer, cloth_info.fixed_points);
+   write_fwgt_chunk(writer, cloth_info.fixed_weights);
+   write_cmsh_chunk(writer, cloth_info.indices);
+   write_constraint_chunk<"SPRS"_mn>(writer, cloth_info.stretch_constraints);
+   write_constraint_chunk<"CPRS"_mn>(writer, cloth_info.cross_constraints);
+   write_constraint_chunk<"BPRS"_mn>(writer, cloth_info.bend_constraints);
+   write_coll_chunk(writer, cloth_info.collision);
+
+   writer.close();
 }
 
-Ucfb_builder create_envl_chunk(const std::vector<std::uint32_t>& bone_map)
+void write_envl_chunk(Ucfb_writer& writer, const std::vector<std::uint32_t>& bone_map)
 {
-   Ucfb_builder envl{"ENVL"_mn};
-   envl.write(static_cast<std::uint32_t>(bone_map.size()));
-
-   for (const auto bone : bone_map) {
-      envl.write(bone);
-   }
-
-   return envl;
+   writer.open("ENVL"_mn);
+   writer.write_counted_array(bone_map);
+   writer.close();
 }
 
-Ucfb_builder create_geom_chunk(const Modl_section& section)
+void write_geom_chunk(Ucfb_writer& writer, const Modl_section& section)
 {
-   Ucfb_builder geom{"GEOM"_mn};
+   writer.open("GEOM"_mn);
 
-   auto& bbox = geom.emplace_child("BBOX"_mn);
-   bbox.write_multiple(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+   writer.open("BBOX"_mn);
+   writer.write_multiple(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+                         0.0f);
+   writer.close();
 
    if (!section.cloth)
-      geom.add_child(create_segm_chunk(section));
+      write_segm_chunk(writer, section);
    else
-      geom.add_child(create_clth_chunk(*section.cloth));
+      write_clth_chunk(writer, *section.cloth);
 
-   if (section.bone_map) geom.add_child(create_envl_chunk(*section.bone_map));
+   if (section.bone_map) write_envl_chunk(writer, *section.bone_map);
 
-   return geom;
+   writer.close();
 }
 
-Ucfb_builder create_swci_chunk(const Modl_collision& collsion)
+void write_swci_chunk(Ucfb_writer& writer, const Modl_collision& collsion)
 {
-   Ucfb_builder swci{"SWCI"_mn};
-
-   swci.write(collsion.type);
-   swci.write_multiple(collsion.size.x, collsion.size.y, collsion.size.z);
-
-   return swci;
+   writer.open("SWCI"_mn);
+   writer.write(collsion.type);
+   writer.write_multiple(collsion.size.x, collsion.size.y, collsion.size.z);
+   writer.close();
 }
 
-Ucfb_builder create_modl_chunk(const Modl_section& section)
+void write_modl_chunk(Ucfb_writer& writer, const Modl_section& section)
 {
-   Ucfb_builder modl{"MODL"_mn};
+   writer.open("MODL"_mn);
+
+   writer.open("MTYP"_mn);
+   writer.write(section.type);
+   writer.close();
 
-   modl.emplace_child("MTYP"_mn).write(section.type);
-   modl.emplace_child("MNDX"_mn).write(section.index);
-   modl.emplace_child("NAME"_mn).write(section.name);
+   writer.open("MNDX"_mn);
+   writer.write(section.index);
+   writer.close();
+
+   writer.open("NAME"_mn);
+   writer.write(section.name);
+   writer.close();
 
    if (!section.parent.empty()) {
-      modl.emplace_child("PRNT"_mn).write(section.parent);
+      writer.open("PRNT"_mn);
+      writer.write(section.parent);
+      writer.close();
    }
 
-   auto& tran = modl.emplace_child("TRAN"_mn);
-   tran.write_multiple(1.0f, 1.0f, 1.0f);
-   tran.write_multiple(section.rotation.x, section.rotation.y, section.rotation.z,
-                       section.rotation.w);
-   tran.write_multiple(section.translation.x, section.translation.y,
-                       section.translation.z);
+   writer.open("TRAN"_mn);
+   writer.write_multiple(1.0f, 1.0f, 1.0f);
+   writer.write_multiple(section.rotation.x, section.rotation.y, section.rotation.z,
+                         section.rotation.w);
+   writer.write_multiple(section.translation.x, section.translation.y,
+                         section.translation.z);
+   writer.close();
 
    if (section.type != Model_type::null && section.type != Model_type::bone) {
-      modl.add_child(create_geom_chunk(section));
+      write_geom_chunk(writer, section);
    }
 
    if (section.collision) {
-      modl.add_child(create_swci_chunk(*section.collision));
+      write_swci_chunk(writer, *section.collision);
    }
 
-   return modl;
+   writer.close();
 }
 
-Ucfb_builder create_matd_chunk(const Material& material, std::size_t index)
+void write_matd_chunk(Ucfb_writer& writer, const Material& material, std::size_t index)
 {
-   Ucfb_builder matd{"MATD"_mn};
-
-   auto& name = matd.emplace_child("NAME"_mn);
-
-   name.write(material.name.value_or("material_"s + std::to_string(index)));
-
-   auto& data = matd.emplace_child("DATA"_mn);
-   data.write_multiple(material.diffuse_colour.r, material.diffuse_colour.g,
-                       material.diffuse_colour.b, material.diffuse_colour.a);
-   data.write_multiple(material.specular_colour.r, material.specular_colour.g,
-                       material.specular_colour.b, material.specular_colour.a);
-   data.write_multiple(1.0f, 1.0f, 1.0f, 1.0f);
-   data.write(material.specular_value);
-
-   auto& atrb = matd.emplace_child("ATRB"_mn);
-   atrb.write(material.flags);
-   atrb.write(material.type);
-   atrb.write(material.params);
+   writer.open("MATD"_mn);
+
+   writer.open("NAME"_mn);
+   writer.write(material.name.value_or("material_"s + std::to_string(index)));
+   writer.close();
+
+   writer.open("DATA"_mn);
+   writer.write_multiple(material.diffuse_colour.r, material.diffuse_colour.g,
+                         material.diffuse_colour.b, material.diffuse_colour.a);
+   writer.write_multiple(material.specular_colour.r, material.specular_colour.g,
+                         material.specular_colour.b, material.specular_colour.a);
+   writer.write_multiple(1.0f, 1.0f, 1.0f, 1.0f);
+   writer.write(material.specular_value);
+   writer.close();
+
+   writer.open("ATRB"_mn);
+   writer.write(material.flags);
+   writer.write(material.type);
+   writer.write(material.params);
+   writer.close();
 
    for (auto i = 0; i < material.textures.size(); ++i) {
       static_assert(std::tuple_size_v<decltype(Material::textures)> <= 10,
                     "Max texture count can not be above 10!");
 
-      auto& tex = matd.emplace_child(
-         create_magic_number('T', 'X', '0' + static_cast<char>(i), 'D'));
+      writer.open(create_magic_number('T', 'X', '0' + static_cast<char>(i), 'D'));
 
       if (!material.textures[i].empty()) {
-         tex.write(material.textures[i]);
+         writer.write(material.textures[i]);
       }
+
+      writer.close();
    }
 
-   return matd;
+   writer.close();
 }
 
-Ucfb_builder create_matl_chunk(std::vector<Modl_section>& sections)
+void write_matl_chunk(Ucfb_writer& writer, std::vector<Modl_section>& sections)
 {
    std::vector<const Material*> materials;
 
@@ -720,57 +788,95 @@ Ucfb_builder create_matl_chunk(std::vector<Modl_section>& sections)
       }
    }
 
-   Ucfb_builder matl{"MATL"_mn};
-
-   matl.write(static_cast<std::uint32_t>(materials.size()));
+   writer.open("MATL"_mn);
+   writer.write(static_cast<std::uint32_t>(materials.size()));
 
    for (std::size_t i = 0; i < materials.size(); ++i) {
-      matl.add_child(create_matd_chunk(*materials[i], i));
+      write_matd_chunk(writer, *materials[i], i);
    }
 
-   return matl;
+   writer.close();
 }
 
-Ucfb_builder create_sinf_chunk(const Bbox msh_bbox, std::string_view model_name)
+void write_sinf_chunk(Ucfb_writer& writer, const Bbox msh_bbox,
+                      std::string_view model_name)
 {
-   Ucfb_builder sinf{"SINF"_mn};
+   writer.open("SINF"_mn);
 
-   auto& name = sinf.emplace_child("NAME"_mn);
-   name.write(model_name);
+   writer.open("NAME"_mn);
+   writer.write(model_name);
+   writer.close();
 
-   auto& fram = sinf.emplace_child("FRAM"_mn);
-
-   fram.write_multiple(0i32, 1i32, 29.97003f);
-
-   auto& bbox = sinf.emplace_child("BBOX"_mn);
+   writer.open("FRAM"_mn);
+   writer.write_multiple(0i32, 1i32, 29.97003f);
+   writer.close();
 
    const auto& rotation = msh_bbox.rotation;
 
-   bbox.write_multiple(rotation.x, rotation.y, rotation.z, rotation.w);
-   bbox.write_multiple(msh_bbox.centre.x, msh_bbox.centre.y, msh_bbox.centre.z);
-   bbox.write_multiple(msh_bbox.size.x, msh_bbox.size.y, msh_bbox.size.z);
-   bbox.write(std::max({msh_bbox.size.x, msh_bbox.size.y, msh_bbox.size.z}) * 2.0f);
+   writer.open("BBOX"_mn);
+   writer.write_multiple(rotation.x, rotation.y, rotation.z, rotation.w);
+   writer.write_multiple(msh_bbox.centre.x, msh_bbox.centre.y, msh_bbox.centre.z);
+   writer.write_multiple(msh_bbox.size.x, msh_bbox.size.y, msh_bbox.size.z);
+   writer.write(std::max({msh_bbox.size.x, msh_bbox.size.y, msh_bbox.size.z}) * 2.0f);
+   writer.close();
 
-   return sinf;
+   writer.close();
 }
 
 std::string create_msh_file(std::vector<Modl_section> sections, const Bbox bbox,
                             std::string_view name)
 {
-   Ucfb_builder hedr{"HEDR"_mn};
+   Ucfb_writer writer{estimate_msh_size(sections)};
 
-   auto& msh2 = hedr.emplace_child("MSH2"_mn);
+   writer.open("HEDR"_mn);
+   writer.open("MSH2"_mn);
 
-   msh2.add_child(create_sinf_chunk(bbox, name));
-   msh2.add_child(create_matl_chunk(sections));
+   write_sinf_chunk(writer, bbox, name);
+   write_matl_chunk(writer, sections);
 
-   for (const auto& section : sections) {
-      msh2.add_child(create_modl_chunk(section));
+   // The MODL chunks are independent of each other so they're written in parallel and
+   // then appended in order.
+   std::vector<std::string> modl_chunks(sections.size());
+
+   tbb::parallel_for(std::size_t{0}, sections.size(), [&](const std::size_t i) {
+      Ucfb_writer modl_writer{estimate_msh_size(sections[i])};
+
+      write_modl_chunk(modl_writer, sections[i]);
+
+      modl_chunks[i] = modl_writer.finish();
+   });
+
+   for (const auto& modl : modl_chunks) {
+      writer.write_chunks(modl);
+   }
+
+   writer.close();
+
+   writer.write_empty("CL1L"_mn);
+
+   writer.close();
+
+   return writer.finish();
+}
+
+// A rough measure of how long the parts of a model take to save.
+std::size_t work_size(const Msh_parts& parts) noexcept
+{
+   std::size_t size = parts.bones.size() + parts.collision_primitives.size();
+
+   for (const auto& model : parts.models) {
+      size += model.positions.size() + model.skin.size();
    }
 
-   hedr.emplace_child("CL1L"_mn);
+   for (const auto& collision : parts.collision_meshes) {
+      size += collision.positions.size();
+   }
 
-   return hedr.create_buffer();
+   for (const auto& cloth : parts.cloths) {
+      size += cloth.positions.size();
+   }
+
+   return size;
 }
 
 std::string create_option_file(const std::vector<Model>& models)
@@ -820,101 +926,199 @@ std::string create_option_file(const std::vector<Model>& models)
 
 namespace msh {
 
-Builder::Builder(const Builder& other) : Builder{}
+Builder::Builder(Builders_map& builders, const String_interner::Id model) noexcept
+   : _builders{builders}, _model{model}
 {
-   this->_bones = other._bones;
-   this->_models = other._models;
-   this->_collision_meshes = other._collision_meshes;
-   this->_collision_primitives = other._collision_primitives;
-   this->_cloths = other._cloths;
+}
 
-   std::lock_guard<tbb::spin_mutex> bbox_lock{other._bbox_mutex};
-   this->_bbox = other._bbox;
+auto Builder::intern(std::string_view name) -> std::string_view
+{
+   return _builders._names.intern_view(name);
 }
 
 void Builder::add_bone(Bone bone)
 {
-   _bones.emplace_back(std::move(bone));
+   _builders.add(_model, std::move(bone));
 }
 
 void Builder::add_model(Model model)
 {
-   _models.emplace_back(std::move(model));
+   _builders.add(_model, std::move(model));
 }
 
 void Builder::add_collision_mesh(Collsion_mesh collision_mesh)
 {
-   _collision_meshes.emplace_back(std::move(collision_mesh));
+   _builders.add(_model, std::move(collision_mesh));
 }
 
 void Builder::add_collision_primitive(Collision_primitive primitive)
 {
-   _collision_primitives.emplace_back(std::move(primitive));
+   _builders.add(_model, std::move(primitive));
 }
 
 void Builder::add_cloth(Cloth cloth)
 {
-   _cloths.emplace_back(std::move(cloth));
+   _builders.add(_model, std::move(cloth));
+}
+
+void Builder::set_bbox(const Bbox& bbox)
+{
+   _builders.add(_model, bbox);
+}
+
+Builder Builders_map::operator[](std::string_view name)
+{
+   return {*this, _names.intern(name)};
 }
 
-void Builder::set_bbox(const Bbox& bbox) noexcept
+void Builders_map::add(const String_interner::Id model, Part part)
 {
-   std::lock_guard<tbb::spin_mutex> bbox_lock{_bbox_mutex};
-   _bbox = bbox;
+   _records.local().push_back({model, std::move(part)});
 }
 
-void Builder::save(const std::string& name, File_saver& file_saver,
-                   const Game_version version) const
+auto Builders_map::group() -> std::vector<Msh_parts>
 {
-   auto bones = downgrade_concurrent_vector(_bones);
-   auto models = downgrade_concurrent_vector(_models);
-   auto cloths = downgrade_concurrent_vector(_cloths);
-   auto collision_meshes = downgrade_concurrent_vector(_collision_meshes);
-   auto collision_primitives = downgrade_concurrent_vector(_collision_primitives);
+   // Count the records of each model, bone and parent names share the id space but
+   // never have records of their own.
+   std::vector<std::size_t> offsets(_names.size() + 1, 0);
+
+   for (const auto& records : _records) {
+      for (const auto& record : records) ++offsets[record.model + 1];
+   }
+
+   std::vector<String_interner::Id> models;
+
+   for (String_interner::Id id = 0; id < _names.size(); ++id) {
+      if (offsets[id + 1] != 0) models.push_back(id);
+
+      offsets[id + 1] += offsets[id];
+   }
+
+   // Scatter the records into one array ordered by model, keeping each thread's
+   // records in the order they were added.
+   std::vector<Record*> sorted(offsets.back());
+   auto heads = offsets;
+
+   for (auto& records : _records) {
+      for (auto& record : records) sorted[heads[record.model]++] = &record;
+   }
+
+   std::vector<Msh_parts> grouped(models.size());
+
+   tbb::parallel_for(std::size_t{0}, models.size(), [&](const std::size_t index) {
+      const auto model = models[index];
+      auto& parts = grouped[index];
+
+      parts.name = _names.view(model);
+
+      for (auto i = offsets[model]; i < offsets[model + 1]; ++i) {
+         std::visit(
+            [&parts](auto&& part) {
+               using Type = std::decay_t<decltype(part)>;
+
+               if constexpr (std::is_same_v<Type, Bone>) {
+                  parts.bones.emplace_back(std::move(part));
+               }
+               else if constexpr (std::is_same_v<Type, Model>) {
+                  parts.models.emplace_back(std::move(part));
+               }
+               else if constexpr (std::is_same_v<Type, Collsion_mesh>) {
+                  parts.collision_meshes.emplace_back(std::move(part));
+               }
+               else if constexpr (std::is_same_v<Type, Collision_primitive>) {
+                  parts.collision_primitives.emplace_back(std::move(part));
+               }
+               else if constexpr (std::is_same_v<Type, Cloth>) {
+                  parts.cloths.emplace_back(std::move(part));
+               }
+               else if constexpr (std::is_same_v<Type, Bbox>) {
+                  parts.bbox = part;
+               }
+            },
+            sorted[i]->part);
+      }
+   });
+
+   _records.clear();
+
+   return grouped;
+}
+
 
-   const auto option_file = create_option_file(models);
+void save(Msh_parts parts, File_saver& file_saver, const Game_version version)
+{
+   const auto option_file = create_option_file(parts.models);
 
    if (version == Game_version::swbf) {
-      for (const auto& cloth : cloths) {
-         models.emplace_back(cloth_to_model(cloth, bones));
+      for (const auto& cloth : parts.cloths) {
+         parts.models.emplace_back(cloth_to_model(cloth, parts.bones));
       }
 
-      cloths.clear();
+      parts.cloths.clear();
    }
 
-   auto msh_file =
-      create_msh_file(create_modl_sections(
-                         std::move(bones), std::move(models), std::move(collision_meshes),
-                         std::move(collision_primitives), std::move(cloths)),
-                      get_bbox(), name);
+   auto sections = create_modl_sections(
+      std::move(parts.bones), std::move(parts.models), std::move(parts.collision_meshes),
+      std::move(parts.collision_primitives), std::move(parts.cloths));
 
-   file_saver.save_file(msh_file, "msh"_sv, name, ".msh"_sv);
+   auto msh_file = create_msh_file(std::move(sections), parts.bbox, parts.name);
+
+   file_saver.save_file(msh_file, "msh"_sv, parts.name, ".msh"_sv);
 
    if (!option_file.empty()) {
-      file_saver.save_file(option_file, "msh"_sv, name, ".msh.option"_sv);
+      file_saver.save_file(option_file, "msh"_sv, parts.name, ".msh.option"_sv);
    }
 }
 
-Bbox Builder::get_bbox() const noexcept
+void save_all(File_saver& file_saver, Builders_map& builders, const Game_version version,
+              std::string_view input_file)
 {
-   std::lock_guard<tbb::spin_mutex> bbox_lock{_bbox_mutex};
-   return _bbox;
-}
+   const auto functor = [&file_saver, version, input_file](Msh_parts& parts) {
+      const auto name = parts.name;
+      const auto start = std::chrono::steady_clock::now();
 
-void save_all(File_saver& file_saver, const Builders_map& builders,
-              const Game_version version)
-{
-   const auto functor = [&file_saver,
-                         version](const std::pair<std::string, Builder>& builder) {
       try {
-         builder.second.save(builder.first, file_saver, version);
+         save(std::move(parts), file_saver, version);
       }
       catch (const std::exception& e) {
-         synced_cout::print("Error: Exception occured while saving ", builder.first,
-                            ".msh\n   Message: "s, e.what(), '\n');
+         file_saver.mark_incomplete();
+
+         error_report::add_error(std::string{input_file}, std::string{name} += ".msh"_sv,
+                                 "msh::save_all"_sv, e.what());
+
+         logger::error("Exception occured while saving ", name, ".msh\n   Message: "s,
+                       e.what());
+
+         return;
+      }
+
+      if (file_saver.verbose()) {
+         const std::chrono::duration<double, std::milli> time =
+            std::chrono::steady_clock::now() - start;
+
+         logger::info("Saved ", name, ".msh in "_sv, time.count(), "ms"_sv);
       }
    };
 
-   tbb::parallel_for_each(builders, functor);
+   auto grouped = builders.group();
+
+   std::vector<std::pair<std::size_t, Msh_parts*>> by_work_size;
+   by_work_size.reserve(grouped.size());
+
+   for (auto& parts : grouped) by_work_size.emplace_back(work_size(parts), &parts);
+
+   std::stable_sort(by_work_size.begin(), by_work_size.end(),
+                    [](const auto& l, const auto& r) { return l.first > r.first; });
+
+   // Models are handed out largest first from a shared counter so one huge model is
+   // never left to start last. Threads that run out of models help with the parallel
+   // loops inside the larger saves that are still running.
+   std::atomic_size_t next_parts{0};
+
+   tbb::parallel_for(0, tbb::this_task_arena::max_concurrency(), [&](int) {
+      for (auto i = next_parts++; i < by_work_size.size(); i = next_parts++) {
+         functor(*by_work_size[i].second);
+      }
+   });
 }
 }
@@ -2,20 +2,21 @@
 
 #include "app_options.hpp"
 #include "file_saver.hpp"
+#include "string_interner.hpp"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/quaternion.hpp"
 
-#include "tbb/concurrent_unordered_map.h"
-#include "tbb/concurrent_vector.h"
-#include "tbb/spin_mutex.h"
+#include "tbb/enumerable_thread_specific.h"
 
 #include <array>
 #include <atomic>
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <variant>
 #include <vector>
 
 namespace msh {
@@ -113,8 +114,11 @@ enum class Lod {
    lowres,
 };
 
+// Names of bones and parents are views of strings interned by the Builder they are
+// added to.
+
 struct Model {
-   std::optional<std::string> parent;
+   std::optional<std::string_view> parent;
    std::optional<std::string> name;
 
    glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
@@ -134,8 +138,8 @@ struct Model {
 };
 
 struct Bone {
-   std::string name;
-   std::string parent;
+   std::string_view name;
+   std::string_view parent;
    glm::vec3 position;
    glm::quat rotation;
 };
@@ -149,7 +153,7 @@ struct Collsion_mesh {
 };
 
 struct Collision_primitive {
-   std::string parent;
+   std::string_view parent;
 
    Primitive_type type = Primitive_type::cube;
    Collision_flags flags = Collision_flags::all;
@@ -162,8 +166,8 @@ struct Collision_primitive {
 struct Cloth_collision;
 
 struct Cloth {
-   std::string name;
-   std::string parent;
+   std::string_view name;
+   std::string_view parent;
 
    glm::quat rotation;
    glm::vec3 position;
@@ -188,11 +192,26 @@ struct Cloth_collision {
    glm::vec3 size{0.0f, 0.0f, 0.0f};
 };
 
+class Builders_map;
+
+//! \brief The parts of one .msh file, gathered from every handler that added to it.
+struct Msh_parts {
+   std::string_view name;
+
+   std::vector<Bone> bones;
+   std::vector<Model> models;
+   std::vector<Collsion_mesh> collision_meshes;
+   std::vector<Collision_primitive> collision_primitives;
+   std::vector<Cloth> cloths;
+   Bbox bbox;
+};
+
+//! \brief Adds the parts of one model to a Builders_map. Cheap to copy.
 class Builder {
 public:
-   Builder() = default;
-
-   Builder(const Builder& other);
+   //! \brief Interns a bone or parent name, the view is valid for the life of the
+   //! Builders_map the builder belongs to.
+   auto intern(std::string_view name) -> std::string_view;
 
    void add_bone(Bone bone);
 
@@ -203,26 +222,62 @@ public:
 
    void add_cloth(Cloth cloth);
 
-   void set_bbox(const Bbox& bbox) noexcept;
+   void set_bbox(const Bbox& bbox);
+
+private:
+   friend class Builders_map;
+
+   Builder(Builders_map& builders, const String_interner::Id model) noexcept;
+
+   Builders_map& _builders;
+   const String_interner::Id _model;
+};
+
+//! \brief Collects the parts of a level's models, keyed by the interned name of each
+//! model.
+//!
+//! Handlers add parts concurrently. Each thread appends them to its own buffer so
+//! adding takes no locks and touches no shared memory. Once every handler is done
+//! group sorts the parts by model with a counting sort over the interned ids and hands
+//! back the parts of each model in contiguous vectors.
+//!
+//! All names used by the builders are interned in the same table, so each distinct
+//! name is stored once per level.
+class Builders_map {
+public:
+   Builders_map() = default;
 
-   void save(const std::string& name, File_saver& file_saver,
-             const Game_version version) const;
+   Builders_map(const Builders_map&) = delete;
+   Builders_map& operator=(const Builders_map&) = delete;
+   Builders_map(Builders_map&&) = delete;
+   Builders_map& operator=(Builders_map&&) = delete;
+
+   //! \brief Gets the builder for a model.
+   Builder operator[](std::string_view name);
+
+   //! \brief Groups the parts added so far by model and clears them from the map.
+   //! Must not be called while parts are still being added.
+   auto group() -> std::vector<Msh_parts>;
 
 private:
-   Bbox get_bbox() const noexcept;
+   friend class Builder;
+
+   using Part =
+      std::variant<Bone, Model, Collsion_mesh, Collision_primitive, Cloth, Bbox>;
+
+   struct Record {
+      String_interner::Id model;
+      Part part;
+   };
 
-   tbb::concurrent_vector<Bone> _bones;
-   tbb::concurrent_vector<Model> _models;
-   tbb::concurrent_vector<Collsion_mesh> _collision_meshes;
-   tbb::concurrent_vector<Collision_primitive> _collision_primitives;
-   tbb::concurrent_vector<Cloth> _cloths;
+   void add(const String_interner::Id model, Part part);
 
-   mutable tbb::spin_mutex _bbox_mutex;
-   Bbox _bbox;
+   String_interner _names;
+   tbb::enumerable_thread_specific<std::vector<Record>> _records;
 };
 
-using Builders_map = tbb::concurrent_unordered_map<std::string, Builder>;
+void save(Msh_parts parts, File_saver& file_saver, const Game_version version);
 
-void save_all(File_saver& file_saver, const Builders_map& builders,
-              const Game_version version);
+void save_all(File_saver& file_saver, Builders_map& builders, const Game_version version,
+              std::string_view input_file);
 }
@@ -0,0 +1,299 @@
+#include "patch_chunk.hpp"
+#include "chunk_index.hpp"
+#include "file_saver.hpp"
+#include "magic_number.hpp"
+#include "mapped_file.hpp"
+#include "string_helpers.hpp"
+#include "swbf_fnv_hashes.hpp"
+#include "type_pun.hpp"
+#include "ucfb_reader.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using namespace std::literals;
+
+namespace {
+
+struct Path_segment {
+   Magic_number magic_number;
+   std::optional<std::uint32_t> name_hash;
+};
+
+struct Size_patch {
+   std::size_t offset;
+   std::uint32_t value;
+};
+
+struct Patch_plan {
+   std::vector<Size_patch> size_patches;
+   std::size_t data_offset = 0;
+   std::size_t old_extent = 0;
+   std::size_t new_extent = 0;
+};
+
+std::size_t aligned_size(const std::size_t size) noexcept
+{
+   return (size + 3) & ~std::size_t{3};
+}
+
+auto parse_segment(std::string_view segment) -> Path_segment
+{
+   const auto [magic_number, name] = split_string(segment, ':');
+
+   if (magic_number.length() != 4) {
+      throw std::runtime_error{"Bad chunk path segment: "s += segment};
+   }
+
+   Path_segment parsed{create_magic_number(magic_number[0], magic_number[1],
+                                           magic_number[2], magic_number[3]),
+                       std::nullopt};
+
+   if (!name.empty()) parsed.name_hash = fnv_1a_hash(name);
+
+   return parsed;
+}
+
+bool matches(Ucfb_reader chunk, const Path_segment& segment) noexcept
+{
+   if (chunk.magic_number() != segment.magic_number) return false;
+
+   if (!segment.name_hash) return true;
+
+   try {
+      if (chunk.magic_number() == "lvl_"_mn) {
+         return chunk.read_trivial<std::uint32_t>() == *segment.name_hash;
+      }
+
+      const auto names = chunk_names(chunk);
+
+      return std::any_of(names.cbegin(), names.cend(), [&](const std::string& name) {
+         return fnv_1a_hash(name) == *segment.name_hash;
+      });
+   }
+   catch (const std::exception&) {
+      return false;
+   }
+}
+
+// Finds the chunk at a path, returning it and every chunk above it, root first.
+auto find_chunk(const Ucfb_reader root, std::string_view chunk_path)
+   -> std::vector<Ucfb_reader>
+{
+   std::vector<Ucfb_reader> chain;
+
+   for (auto remaining = chunk_path; !remaining.empty();) {
+      const auto [segment_string, rest] = split_string(remaining, '/');
+      remaining = rest;
+
+      const auto segment = parse_segment(segment_string);
+
+      if (chain.empty()) {
+         if (!matches(root, segment)) {
+            throw std::runtime_error{"Chunk not found: "s += chunk_path};
+         }
+
+         chain.push_back(root);
+
+         continue;
+      }
+
+      auto parent = chain.back();
+
+      if (parent.magic_number() == "lvl_"_mn) {
+         parent.consume(4); // lvl name hash
+         parent.consume(4); // lvl size left
+      }
+
+      std::optional<Ucfb_reader> found;
+
+      while (parent && !found) {
+         const auto child = parent.read_child();
+
+         if (matches(child, segment)) found.emplace(child);
+      }
+
+      if (!found) throw std::runtime_error{"Chunk not found: "s += chunk_path};
+
+      chain.push_back(*found);
+   }
+
+   if (chain.size() < 2) {
+      throw std::runtime_error{"The root chunk of a file can not be patched."};
+   }
+
+   return chain;
+}
+
+std::uint32_t checked_size(const std::int64_t size)
+{
+   if (size < 0 || size > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::runtime_error{"Patched chunk would be too large."};
+   }
+
+   return static_cast<std::uint32_t>(size);
+}
+
+auto plan_patch(gsl::span<const std::byte> file_bytes, std::string_view chunk_path,
+                const std::size_t new_size) -> Patch_plan
+{
+   const auto file_begin = file_bytes.data();
+
+   const auto chain = find_chunk(Ucfb_reader{file_bytes}, chunk_path);
+
+   const auto offset_of = [file_begin](const Ucfb_reader& chunk) {
+      return static_cast<std::size_t>(chunk.bytes().data() - file_begin);
+   };
+
+   const auto& target = chain.back();
+
+   Patch_plan plan;
+   plan.data_offset = offset_of(target);
+
+   // Anything after the target starts aligned. When nothing follows it in the file there
+   // is no padding after it, and none is added after the new contents either.
+   const auto old_end = plan.data_offset + target.size();
+   const auto root_end = offset_of(chain.front()) + chain.front().size();
+   const bool padded = root_end > old_end;
+
+   plan.old_extent = padded ? aligned_size(target.size()) : target.size();
+   plan.new_extent = padded ? aligned_size(new_size) : new_size;
+
+   const auto size_delta =
+      static_cast<std::int64_t>(new_size) - static_cast<std::int64_t>(target.size());
+   const auto extent_delta = static_cast<std::int64_t>(plan.new_extent) -
+                             static_cast<std::int64_t>(plan.old_extent);
+
+   for (auto it = chain.cbegin(); it != std::prev(chain.cend()); ++it) {
+      const auto offset = offset_of(*it);
+      const auto end = offset + it->size();
+
+      // A chunk ending with the target has no padding after the target's contents, so
+      // grows by exactly as much as the contents. A chunk holding more than the target
+      // has the padding recomputed for the new contents and grows by the padded size.
+      std::int64_t delta = 0;
+
+      if (end == old_end) {
+         delta = size_delta;
+      }
+      else if (end >= plan.data_offset + plan.old_extent) {
+         delta = extent_delta;
+      }
+      else {
+         throw std::runtime_error{"A chunk above the patched chunk ends in its padding."};
+      }
+
+      plan.size_patches.push_back(
+         {offset - 4, checked_size(static_cast<std::int64_t>(it->size()) + delta)});
+
+      if (it->magic_number() == "lvl_"_mn) {
+         auto lvl = *it;
+         lvl.consume(4); // lvl name hash
+
+         const auto size_left = lvl.read_trivial<std::uint32_t>();
+
+         plan.size_patches.push_back({offset + 4, checked_size(size_left + delta)});
+      }
+   }
+
+   plan.size_patches.push_back(
+      {plan.data_offset - 4, checked_size(static_cast<std::int64_t>(new_size))});
+
+   std::sort(plan.size_patches.begin(), plan.size_patches.end(),
+             [](const Size_patch& left, const Size_patch& right) {
+                return left.offset < right.offset;
+             });
+
+   return plan;
+}
+
+template<typename Stream>
+void write_contents(Stream& stream, const Patch_plan& plan,
+                    gsl::span<const std::byte> contents)
+{
+   constexpr std::array<char, 4> padding{};
+
+   const auto size = static_cast<std::size_t>(contents.size());
+
+   stream.write(reinterpret_cast<const char*>(contents.data()), size);
+   stream.write(padding.data(), plan.new_extent - size);
+}
+
+void write_patched_file(std::ostream& file, gsl::span<const std::byte> file_bytes,
+                        const Patch_plan& plan, gsl::span<const std::byte> contents)
+{
+   const auto copy_range = [&](const std::size_t begin, const std::size_t end) {
+      file.write(reinterpret_cast<const char*>(file_bytes.data()) + begin, end - begin);
+   };
+
+   std::size_t position = 0;
+
+   for (const auto& patch : plan.size_patches) {
+      copy_range(position, patch.offset);
+      file.write(view_pod_as_string(patch.value).data(), sizeof(patch.value));
+
+      position = patch.offset + sizeof(patch.value);
+   }
+
+   copy_range(position, plan.data_offset);
+   write_contents(file, plan, contents);
+   copy_range(plan.data_offset + plan.old_extent,
+              static_cast<std::size_t>(file_bytes.size()));
+}
+
+void write_in_place(const fs::path& path, const Patch_plan& plan,
+                    gsl::span<const std::byte> contents)
+{
+   std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+
+   for (const auto& patch : plan.size_patches) {
+      file.seekp(patch.offset);
+      file.write(view_pod_as_string(patch.value).data(), sizeof(patch.value));
+   }
+
+   file.seekp(plan.data_offset);
+   write_contents(file, plan, contents);
+
+   if (!file) throw std::runtime_error{"Failed to write file: "s += path.u8string()};
+}
+}
+
+void patch_chunk(const fs::path& file, std::string_view chunk_path,
+                 const fs::path& replacement)
+{
+   // Empty files can not be mapped.
+   const auto replacement_file =
+      fs::file_size(replacement) != 0 ? Mapped_file{replacement} : Mapped_file{};
+   const auto contents = replacement_file.bytes();
+
+   Mapped_file input_file{file};
+
+   const auto plan = plan_patch(input_file.bytes(), chunk_path,
+                                static_cast<std::size_t>(contents.size()));
+
+   // The input file is only written to or replaced once it is no longer mapped.
+   if (plan.new_extent == plan.old_extent) {
+      input_file = Mapped_file{};
+
+      write_in_place(file, plan, contents);
+   }
+   else {
+      write_file_atomically(file, [&](std::ofstream& output) {
+         write_patched_file(output, input_file.bytes(), plan, contents);
+
+         input_file = Mapped_file{};
+      });
+   }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+//! \brief Replaces the contents of a single chunk in a munged file.
+//!
+//! The chunk is found by the path of magic numbers leading to it from the root chunk,
+//! separated by '/', such as "ucfb/lvl_/tex_". A magic number can be followed by ':'
+//! and a name to pick the chunk with that name, or for lvl_ chunks the level with that
+//! name. Otherwise the first chunk with the magic number is picked.
+//!
+//! The sizes of the chunk and every chunk above it are fixed up. When the chunk's padded
+//! size is unchanged the file is written in place. Otherwise the file is rewritten under
+//! a temporary name and renamed into place, with the bytes around the chunk copied
+//! straight from a mapping of the original.
+//!
+//! \param file The file to patch.
+//! \param chunk_path The path of the chunk to replace.
+//! \param replacement The file holding the new contents of the chunk, without a header.
+//!
+//! \exception std::runtime_error Thrown when the chunk can not be found or the patched
+//! file would be too large.
+void patch_chunk(const std::filesystem::path& file, std::string_view chunk_path,
+                 const std::filesystem::path& replacement);
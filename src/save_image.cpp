@@ -6,7 +6,9 @@
 #include "DirectXTex.h"
 
 #include <codecvt>
+#include <filesystem>
 #include <locale>
+#include <stdexcept>
 
 namespace {
 
@@ -50,30 +52,53 @@ void ensure_basic_format(DirectX::ScratchImage& image)
 void save_image(std::string_view name, DirectX::ScratchImage image,
                 File_saver& file_saver, Image_format save_format)
 {
-   const auto utf8_path = file_saver.get_file_path("textures"_sv, name, "");
+   const auto extension = [save_format] {
+      if (save_format == Image_format::png) return ".png"_sv;
+      if (save_format == Image_format::dds) return ".dds"_sv;
+
+      return ".tga"_sv;
+   }();
+
+   // Verifying only needs the decoded pixels, converting and encoding them is skipped.
+   if (file_saver.discards_output()) {
+      file_saver.save_file({reinterpret_cast<const char*>(image.GetPixels()),
+                            image.GetPixelsSize()},
+                           "textures"_sv, name, extension);
+
+      return;
+   }
+
+   const auto utf8_path = file_saver.get_file_path("textures"_sv, name, extension);
 
    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-   auto path = converter.from_bytes(utf8_path);
+   const auto path = converter.from_bytes(utf8_path);
+   const auto temp_path = temporary_file_path(path).wstring();
 
-   if (save_format == Image_format::tga) {
-      path += L".tga"_sv;
+   HRESULT result = E_FAIL;
 
+   if (save_format == Image_format::tga) {
       ensure_basic_format(image);
 
-      DirectX::SaveToTGAFile(*image.GetImage(0, 0, 0), path.c_str());
+      result = DirectX::SaveToTGAFile(*image.GetImage(0, 0, 0), temp_path.c_str());
    }
    else if (save_format == Image_format::png) {
-      path += L".png"_sv;
-
       ensure_basic_format(image);
 
-      DirectX::SaveToWICFile(*image.GetImage(0, 0, 0), DirectX::WIC_FLAGS_NONE,
-                             DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG), path.c_str());
+      result = DirectX::SaveToWICFile(*image.GetImage(0, 0, 0), DirectX::WIC_FLAGS_NONE,
+                                      DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG),
+                                      temp_path.c_str());
    }
    else if (save_format == Image_format::dds) {
-      path += L".dds"_sv;
+      result = DirectX::SaveToDDSFile(image.GetImages(), image.GetImageCount(),
+                                      image.GetMetadata(), DirectX::DDS_FLAGS_NONE,
+                                      temp_path.c_str());
+   }
 
-      DirectX::SaveToDDSFile(image.GetImages(), image.GetImageCount(),
-                             image.GetMetadata(), DirectX::DDS_FLAGS_NONE, path.c_str());
+   if (FAILED(result)) {
+      std::filesystem::remove(temp_path);
+
+      throw std::runtime_error{std::string{"Failed to save texture: "} += name};
    }
+
+   std::filesystem::rename(temp_path, path);
 }
@@ -89,6 +89,45 @@ inline std::string to_hexstring(const Integral integer) noexcept
    return stream.str();
 }
 
+inline std::string json_escape(std::string_view string)
+{
+   constexpr auto hex_digits = "0123456789abcdef"_sv;
+
+   std::string escaped;
+   escaped.reserve(string.size());
+
+   for (const char c : string) {
+      switch (c) {
+      case '"':
+         escaped += "\\\""_sv;
+         break;
+      case '\\':
+         escaped += "\\\\"_sv;
+         break;
+      case '\n':
+         escaped += "\\n"_sv;
+         break;
+      case '\r':
+         escaped += "\\r"_sv;
+         break;
+      case '\t':
+         escaped += "\\t"_sv;
+         break;
+      default:
+         if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += "\\u00"_sv;
+            escaped += hex_digits[(c >> 4) & 0xf];
+            escaped += hex_digits[c & 0xf];
+         }
+         else {
+            escaped += c;
+         }
+      }
+   }
+
+   return escaped;
+}
+
 inline void copy_to_cstring(std::string_view from, char* const to, const std::size_t size)
 {
    const std::size_t length = (from.length() > size - 1) ? (size - 1) : from.length();
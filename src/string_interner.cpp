@@ -0,0 +1,30 @@
+#include "string_interner.hpp"
+
+auto String_interner::intern(std::string_view string) -> Id
+{
+   if (const auto existing = _ids.find(string); existing != std::cend(_ids)) {
+      return existing->second;
+   }
+
+   const auto stored = _strings.emplace_back(string);
+   const auto id = static_cast<Id>(stored - _strings.begin());
+
+   // If another thread interned the same string first its id wins and the copy made
+   // here is left unused.
+   return _ids.insert({std::string_view{*stored}, id}).first->second;
+}
+
+auto String_interner::intern_view(std::string_view string) -> std::string_view
+{
+   return view(intern(string));
+}
+
+auto String_interner::view(const Id id) const noexcept -> std::string_view
+{
+   return _strings[id];
+}
+
+std::size_t String_interner::size() const noexcept
+{
+   return _strings.size();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "tbb/concurrent_unordered_map.h"
+#include "tbb/concurrent_vector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+//! \brief Threadsafe table giving each distinct string a small id and a single copy.
+//!
+//! Each distinct string is copied once, the first time it is interned, and looking up
+//! a string that is already interned does not allocate. Ids and views stay valid for
+//! the life of the interner, as interned strings are never moved or freed.
+class String_interner {
+public:
+   using Id = std::uint32_t;
+
+   String_interner() = default;
+
+   String_interner(const String_interner&) = delete;
+   String_interner& operator=(const String_interner&) = delete;
+   String_interner(String_interner&&) = delete;
+   String_interner& operator=(String_interner&&) = delete;
+
+   Id intern(std::string_view string);
+
+   //! \brief Interns a string and returns a view of the interned copy.
+   auto intern_view(std::string_view string) -> std::string_view;
+
+   auto view(const Id id) const noexcept -> std::string_view;
+
+   //! \brief Gets one past the largest id handed out so far.
+   std::size_t size() const noexcept;
+
+private:
+   tbb::concurrent_vector<std::string> _strings;
+   tbb::concurrent_unordered_map<std::string_view, Id, std::hash<std::string_view>> _ids;
+};
@@ -1,11 +1,12 @@
 
 #include "swbf_fnv_hashes.hpp"
-#include "synced_cout.hpp"
+#include "logger.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 using namespace std::literals;
 
@@ -17,7 +18,29 @@ constexpr std::pair<std::uint32_t, std::string_view> operator""_fnvp(const char*
    return {fnv_1a_hash({str, length}), {str, length}};
 }
 
-const std::unordered_map<std::uint32_t, std::string_view> swbf_hashes{
+using Hash_entry = std::pair<std::uint32_t, std::string_view>;
+
+// Sorts the known names by hash so they can be binary searched. Where two names share a
+// hash the first one listed is kept.
+auto create_hash_index(std::vector<Hash_entry> entries) -> std::vector<Hash_entry>
+{
+   const auto hash_less = [](const Hash_entry& l, const Hash_entry& r) {
+      return l.first < r.first;
+   };
+
+   std::stable_sort(entries.begin(), entries.end(), hash_less);
+
+   entries.erase(std::unique(entries.begin(), entries.end(),
+                             [](const Hash_entry& l, const Hash_entry& r) {
+                                return l.first == r.first;
+                             }),
+                 entries.end());
+   entries.shrink_to_fit();
+
+   return entries;
+}
+
+const std::vector<Hash_entry> swbf_hashes = create_hash_index({
    "0"_fnvp,
    "1"_fnvp,
    "1flag"_fnvp,
@@ -2817,16 +2840,27 @@ const std::unordered_map<std::uint32_t, std::string_view> swbf_hashes{
    "ZoomRate"_fnvp,
    "ZoomTurnDivisorMax"_fnvp,
    "ZoomTurnDivisorMin"_fnvp,
-   "ZOrder"_fnvp};
+   "ZOrder"_fnvp});
 }
 
-std::string lookup_fnv_hash(const std::uint32_t hash)
+auto find_fnv_hash(const std::uint32_t hash) noexcept -> std::optional<std::string_view>
 {
-   const auto result = swbf_hashes.find(hash);
+   const auto result =
+      std::lower_bound(swbf_hashes.cbegin(), swbf_hashes.cend(), hash,
+                       [](const Hash_entry& entry, const std::uint32_t hash) {
+                          return entry.first < hash;
+                       });
+
+   if (result == swbf_hashes.cend() || result->first != hash) return std::nullopt;
+
+   return result->second;
+}
 
-   if (result != std::cend(swbf_hashes)) return std::string{result->second};
+std::string lookup_fnv_hash(const std::uint32_t hash)
+{
+   if (const auto name = find_fnv_hash(hash); name) return std::string{*name};
 
-   synced_cout::print("Warning: Unknown hash looked up.\n"s, "   value: "s, hash, '\n');
+   logger::warning("Unknown hash looked up.\n"s, "   value: "s, hash);
 
    return std::to_string(hash);
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 
 constexpr std::uint32_t fnv_1a_hash(const std::string_view str)
 {
@@ -25,4 +27,8 @@ constexpr std::uint32_t operator""_fnv(const char* str, const std::size_t length
    return fnv_1a_hash({str, length});
 }
 
-std::string lookup_fnv_hash(std::uint32_t hash);
\ No newline at end of file
+// Finds the name a hash was made from, if it is one of the known names. Does not allocate
+// or log, for hot paths that resolve many hashes.
+auto find_fnv_hash(std::uint32_t hash) noexcept -> std::optional<std::string_view>;
+
+std::string lookup_fnv_hash(std::uint32_t hash);
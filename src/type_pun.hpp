@@ -2,6 +2,8 @@
 
 #include <gsl/gsl>
 
+#include <array>
+#include <cstring>
 #include <string>
 #include <type_traits>
 
@@ -53,3 +55,21 @@ inline std::string_view view_pod_span_as_string(gsl::span<const Pod> array)
    return {reinterpret_cast<const char*>(array.data()),
            static_cast<std::size_t>(array.size_bytes())};
 }
+
+// Copies several values into one array of chars, so they can be appended in one go.
+template<typename... Pods>
+inline auto pack_pods(const Pods&... pods) noexcept
+   -> std::array<char, (sizeof(Pods) + ...)>
+{
+   static_assert((std::is_trivially_copyable_v<Pods> && ...),
+                 "Types must be trivially copyable.");
+   static_assert((!std::is_pointer_v<Pods> && ...), "Types can not be pointers.");
+
+   std::array<char, (sizeof(Pods) + ...)> packed;
+   std::size_t offset = 0;
+
+   ((std::memcpy(packed.data() + offset, &pods, sizeof(Pods)), offset += sizeof(Pods)),
+    ...);
+
+   return packed;
+}
@@ -1,11 +1,14 @@
 #include "ucfb_builder.hpp"
+#include "mapped_file.hpp"
 
-#include <fstream>
+#include <array>
 #include <limits>
 #include <stdexcept>
 
 namespace fs = std::filesystem;
 
+using namespace std::literals;
+
 namespace {
 std::size_t needed_padding(const std::size_t size) noexcept
 {
@@ -22,16 +25,11 @@ Ucfb_builder::Ucfb_builder(Magic_number magic_number)
    _magic_number = magic_number;
 }
 
-Ucfb_builder::Ucfb_builder(const fs::path& file_path, Magic_number magic_number)
-   : Ucfb_builder{magic_number}
+Ucfb_builder::Ucfb_builder(fs::path file_path, Magic_number magic_number)
+   : _magic_number{magic_number},
+     _contents_file{std::move(file_path)},
+     _contents_file_size{static_cast<std::size_t>(fs::file_size(_contents_file))}
 {
-   const auto size = fs::file_size(file_path);
-
-   std::ifstream file{file_path, std::ios::in | std::ios::binary};
-
-   _contents.resize(size);
-
-   file.read(_contents.data(), size);
 }
 
 Magic_number Ucfb_builder::get_magic_number() const noexcept
@@ -65,6 +63,11 @@ void Ucfb_builder::write(std::string_view str, bool null_terminate, bool aligned
    if (aligned) pad_till_aligned();
 }
 
+void Ucfb_builder::reserve_children(const std::size_t children_count)
+{
+   _children.reserve(children_count);
+}
+
 void Ucfb_builder::pad_till_aligned()
 {
    _contents.append(needed_padding(_contents.size()), '\0');
@@ -72,34 +75,74 @@ void Ucfb_builder::pad_till_aligned()
 
 std::string Ucfb_builder::create_buffer() const
 {
+   std::string buffer;
+   buffer.reserve(calc_size());
+
+   write_blocks([&buffer](std::string_view block) { buffer += block; });
+
+   return buffer;
+}
+
+void Ucfb_builder::write_blocks(const Block_sink& sink) const
+{
+   write_chunk(sink);
+}
+
+std::size_t Ucfb_builder::write_chunk(const Block_sink& sink) const
+{
+   constexpr std::array<char, 4> padding{};
+
    const auto size = calc_size();
 
    if (size > std::numeric_limits<std::uint32_t>::max()) {
       throw std::out_of_range{"ucfb file too large"};
    }
 
-   std::string buffer;
-   buffer.reserve(size);
+   const auto size_minus_header = static_cast<std::uint32_t>(size - 8);
 
-   buffer += view_pod_as_string(_magic_number);
+   sink(view_pod_as_string(_magic_number));
+   sink(view_pod_as_string(size_minus_header));
 
-   const auto size_minus_header = static_cast<std::uint32_t>(size - 8);
-   buffer += view_pod_as_string(size_minus_header);
+   if (_contents_file_size != 0) {
+      const Mapped_file file{_contents_file};
+      const auto bytes = file.bytes();
+
+      // The sizes of every chunk above this one were written from the size taken when
+      // the builder was created.
+      if (static_cast<std::size_t>(bytes.size()) != _contents_file_size) {
+         throw std::runtime_error{"Chunk file changed size while being assembled: "s +=
+                                  _contents_file.u8string()};
+      }
+
+      sink({reinterpret_cast<const char*>(bytes.data()), _contents_file_size});
+   }
 
-   buffer += _contents;
-   buffer.append(needed_padding(buffer.size()), '\0');
+   if (!_contents.empty()) sink(_contents);
+
+   std::size_t written = 8 + _contents_file_size + _contents.size();
+
+   const auto pad = [&] {
+      const auto padding_size = needed_padding(written);
+
+      if (padding_size != 0) sink({padding.data(), padding_size});
+
+      written += padding_size;
+   };
+
+   pad();
 
    for (const auto& child : _children) {
-      buffer += child.create_buffer();
-      buffer.append(needed_padding(buffer.size()), '\0');
+      written += child.write_chunk(sink);
+
+      pad();
    }
 
-   return buffer;
+   return written;
 }
 
 std::size_t Ucfb_builder::calc_size() const noexcept
 {
-   std::size_t size = 8 + _contents.size();
+   std::size_t size = 8 + _contents_file_size + _contents.size();
 
    for (const auto& child : _children) {
       size += child.calc_size();
@@ -5,7 +5,9 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <vector>
 
@@ -13,10 +15,15 @@ class Ucfb_builder {
 public:
    using iterator = std::vector<Ucfb_builder>::iterator;
    using const_iterator = std::vector<Ucfb_builder>::const_iterator;
+   using Block_sink = std::function<void(std::string_view block)>;
 
    explicit Ucfb_builder(Magic_number magic_number);
 
-   Ucfb_builder(const std::filesystem::path& file_path, Magic_number magic_number);
+   //! \brief Creates a builder whose contents start with those of a file.
+   //!
+   //! The file's size is taken now, but it is not read until the builder is written out,
+   //! and then its contents are passed on straight from a mapping of it.
+   Ucfb_builder(std::filesystem::path file_path, Magic_number magic_number);
 
    Magic_number get_magic_number() const noexcept;
 
@@ -70,14 +77,30 @@ public:
       const bool unused[] = {false, (write(std::forward<Pod_types>(pods)), false)...};
    }
 
+   //! \brief Reserves space for the children that are about to be added, so they are not
+   //! reallocated as they are added.
+   void reserve_children(const std::size_t children_count);
+
    void pad_till_aligned();
 
    std::string create_buffer() const;
 
+   //! \brief Writes out the chunk and its children in blocks, in order. Contents read
+   //! from files are passed on in a single block each, without being copied.
+   //!
+   //! \exception std::out_of_range Thrown when a chunk is too large for its size field.
+   //! \exception std::runtime_error Thrown when a contents file can not be read or has
+   //! changed size since the builder was created.
+   void write_blocks(const Block_sink& sink) const;
+
 private:
    std::size_t calc_size() const noexcept;
 
+   std::size_t write_chunk(const Block_sink& sink) const;
+
    Magic_number _magic_number;
+   std::filesystem::path _contents_file;
+   std::size_t _contents_file_size = 0;
    std::string _contents;
    std::vector<Ucfb_builder> _children;
 };
@@ -122,6 +122,11 @@ std::size_t Ucfb_reader::size() const noexcept
    return _size;
 }
 
+gsl::span<const std::byte> Ucfb_reader::bytes() const noexcept
+{
+   return {_data, static_cast<gsl::span<const std::byte>::index_type>(_size)};
+}
+
 void Ucfb_reader::check_head()
 {
    if (_head > _size) {
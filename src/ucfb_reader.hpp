@@ -342,6 +342,11 @@ public:
    //! \return The size the chunk.
    std::size_t size() const noexcept;
 
+   //! \brief Gets a view of the chunk's data, not including it's header.
+   //!
+   //! \return A span of the chunk's data. Independent of the read head.
+   gsl::span<const std::byte> bytes() const noexcept;
+
 private:
    // Special constructor for use by read_child, performs no error checking.
    Ucfb_reader(const Magic_number mn, const std::uint32_t size,
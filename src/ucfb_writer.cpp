@@ -0,0 +1,76 @@
+#include "ucfb_writer.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+Ucfb_writer::Ucfb_writer(const std::size_t expected_size)
+{
+   _buffer.reserve(expected_size);
+}
+
+void Ucfb_writer::open(const Magic_number magic_number)
+{
+   // Children always start aligned, after their parent's contents.
+   pad_till_aligned();
+
+   _open_chunks.push_back(_buffer.size());
+
+   write(magic_number);
+   write(std::uint32_t{0});
+}
+
+void Ucfb_writer::close()
+{
+   Expects(!_open_chunks.empty());
+
+   const auto chunk_offset = _open_chunks.back();
+   _open_chunks.pop_back();
+
+   const auto size = _buffer.size() - chunk_offset - 8;
+
+   if (size > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::out_of_range{"ucfb file too large"};
+   }
+
+   const auto size_field = static_cast<std::uint32_t>(size);
+
+   std::memcpy(&_buffer[chunk_offset + 4], &size_field, sizeof(size_field));
+
+   // Like Ucfb_builder the padding after the chunk is not part of its size.
+   pad_till_aligned();
+}
+
+void Ucfb_writer::write_empty(const Magic_number magic_number)
+{
+   open(magic_number);
+   close();
+}
+
+void Ucfb_writer::write(std::string_view str, bool null_terminate, bool aligned)
+{
+   _buffer += str;
+
+   if (null_terminate) _buffer += '\0';
+
+   if (aligned) pad_till_aligned();
+}
+
+void Ucfb_writer::write_chunks(std::string_view chunks)
+{
+   pad_till_aligned();
+
+   _buffer += chunks;
+}
+
+void Ucfb_writer::pad_till_aligned()
+{
+   if (_buffer.size() % 4) _buffer.append(4 - (_buffer.size() % 4), '\0');
+}
+
+std::string Ucfb_writer::finish()
+{
+   Expects(_open_chunks.empty());
+
+   return std::move(_buffer);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "magic_number.hpp"
+#include "type_pun.hpp"
+
+#include <gsl/gsl>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+//! \brief Writes ucfb chunks straight into a single buffer.
+//!
+//! Unlike Ucfb_builder no tree of chunks is built, chunks are opened and closed in the
+//! order they appear in the file and the size of each is patched into its header when
+//! it is closed. Nothing is copied after it is written, so reserving the expected size
+//! up front means the file's bytes are written exactly once.
+class Ucfb_writer {
+public:
+   explicit Ucfb_writer(const std::size_t expected_size = 0);
+
+   //! \brief Starts a chunk, anything written until the matching close is its contents.
+   void open(const Magic_number magic_number);
+
+   //! \brief Patches in the size of the current chunk and pads it to four bytes.
+   //!
+   //! \exception std::out_of_range Thrown when the chunk is too large for its size
+   //! field.
+   void close();
+
+   //! \brief Writes an empty chunk.
+   void write_empty(const Magic_number magic_number);
+
+   void write(std::string_view str, bool null_terminate = true, bool aligned = true);
+
+   template<typename Pod, typename = std::enable_if_t<std::is_pod_v<Pod>>>
+   void write(const Pod& pod)
+   {
+      _buffer += view_pod_as_string(pod);
+   }
+
+   template<typename... Pod_types>
+   void write_multiple(const Pod_types&... pods)
+   {
+      const auto packed = pack_pods(pods...);
+
+      _buffer.append(packed.data(), packed.size());
+   }
+
+   //! \brief Writes an array of values, copied in one go.
+   template<typename Type>
+   void write_array(gsl::span<const Type> values)
+   {
+      static_assert(std::is_trivially_copyable_v<Type>,
+                    "Type must be trivially copyable.");
+
+      _buffer.append(reinterpret_cast<const char*>(values.data()),
+                     static_cast<std::size_t>(values.size_bytes()));
+   }
+
+   //! \brief Writes a count followed by the values, copied in one go.
+   template<typename Type>
+   void write_counted_array(const std::vector<Type>& values)
+   {
+      write(static_cast<std::uint32_t>(values.size()));
+      write_array(gsl::span<const Type>{values});
+   }
+
+   //! \brief Appends whole chunks, as written by another Ucfb_writer.
+   void write_chunks(std::string_view chunks);
+
+   void pad_till_aligned();
+
+   //! \brief Takes the written buffer, every chunk must have been closed.
+   std::string finish();
+
+private:
+   std::string _buffer;
+   std::vector<std::size_t> _open_chunks;
+};
@@ -1,9 +1,9 @@
 
 #include "glm_pod_wrappers.hpp"
+#include "logger.hpp"
 #include "magic_number.hpp"
 #include "msh_builder.hpp"
 #include "string_helpers.hpp"
-#include "synced_cout.hpp"
 #include "ucfb_reader.hpp"
 
 #include <array>
@@ -52,8 +52,7 @@ void print_failed_search(const std::vector<Ucfb_reader_strict<"VBUF"_mn>>& vbufs
       stream << "\n      type:" << to_hexstring(static_cast<std::uint32_t>(info.type));
    }
 
-   synced_cout::print("Warning: Unable to find usable VBUF type options are:"s,
-                      stream.str(), '\n');
+   logger::warning("Unable to find usable VBUF type options are:"s, stream.str());
 }
 
 auto find_best_usable_vbuf(const std::vector<Ucfb_reader_strict<"VBUF"_mn>>& vbufs)
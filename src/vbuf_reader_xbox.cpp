@@ -1,7 +1,7 @@
 
+#include "logger.hpp"
 #include "msh_builder.hpp"
 #include "string_helpers.hpp"
-#include "synced_cout.hpp"
 #include "ucfb_reader.hpp"
 
 #include <array>
@@ -363,9 +363,9 @@ void read_vbuf_xbox(Ucfb_reader_strict<"VBUF"_mn> vbuf, msh::Model& model,
    case Vbuf_type::textured_softskinned_normal_mapped:
       return read_textured_softskinned_normal_mapped(vbuf, info, model, vert_box);
    default:
-      synced_cout::print("Warning: Unknown Xbox VBUF encountered."s, "\n   size : "s,
-                         vbuf.size(), "\n   entry count: "s, info.count, "\n   stride: "s,
-                         info.stride, "\n   entry type: "s,
-                         to_hexstring(static_cast<std::uint32_t>(info.type)), '\n');
+      logger::warning("Unknown Xbox VBUF encountered."s, "\n   size : "s, vbuf.size(),
+                      "\n   entry count: "s, info.count, "\n   stride: "s, info.stride,
+                      "\n   entry type: "s,
+                      to_hexstring(static_cast<std::uint32_t>(info.type)));
    }
 }
@@ -0,0 +1,77 @@
+#include "verify_manifest.hpp"
+#include "content_hash.hpp"
+#include "string_helpers.hpp"
+
+#include <algorithm>
+
+namespace fs = std::filesystem;
+using namespace std::literals;
+
+namespace {
+
+constexpr auto manifest_header = "swbf-unmunge-verify 1"_sv;
+
+void append_chunks(Ucfb_reader parent, const std::byte* const file_begin,
+                   const std::string& parent_path, std::string& manifest)
+{
+   if (parent.magic_number() == "lvl_"_mn) {
+      parent.consume(4); // lvl name hash
+      parent.consume(4); // lvl size left
+   }
+
+   while (parent) {
+      const auto child = parent.read_child();
+
+      auto path = parent_path;
+      path += '/';
+      path += view_pod_as_string(child.magic_number());
+
+      // Offsets are of the chunk's header, so they line up with a hex editor.
+      const auto offset = static_cast<std::size_t>(child.bytes().data() - file_begin) - 8;
+
+      manifest += "chunk "_sv;
+      manifest += std::to_string(offset);
+      manifest += ' ';
+      manifest += std::to_string(child.size());
+      manifest += ' ';
+      manifest += content_hash_string(
+         content_hash(child.bytes(), static_cast<std::uint32_t>(child.magic_number())));
+      manifest += ' ';
+      manifest += path;
+      manifest += '\n';
+
+      if (child.magic_number() == "lvl_"_mn) {
+         append_chunks(child, file_begin, path, manifest);
+      }
+   }
+}
+}
+
+auto create_verify_manifest(Ucfb_reader root, const fs::path& output_directory,
+                            std::vector<Output_checksum> outputs) -> std::string
+{
+   std::string manifest;
+
+   manifest += manifest_header;
+   manifest += '\n';
+
+   append_chunks(root, root.bytes().data() - 8,
+                 std::string{view_pod_as_string(root.magic_number())}, manifest);
+
+   // Outputs are recorded in whatever order the handlers finished in.
+   std::sort(std::begin(outputs), std::end(outputs),
+             [](const Output_checksum& left, const Output_checksum& right) {
+                return left.file < right.file;
+             });
+
+   for (const auto& output : outputs) {
+      manifest += "output "_sv;
+      manifest += content_hash_string(output.checksum);
+      manifest += ' ';
+      manifest +=
+         fs::u8path(output.file).lexically_relative(output_directory).generic_u8string();
+      manifest += '\n';
+   }
+
+   return manifest;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "file_saver.hpp"
+#include "ucfb_reader.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+//! \brief Creates the checksum manifest of a verified input file.
+//!
+//! The manifest lists the offset, size and checksum of every top level chunk, including
+//! the children of lvl_ chunks, followed by the checksum of every file extraction would
+//! output. Comparing the manifests of two runs shows which chunks and outputs changed.
+//!
+//! \param root The root chunk of the input file.
+//! \param output_directory The directory output files are named relative to.
+//! \param outputs The output checksums recorded by a discarding File_saver.
+//!
+//! \exception std::runtime_error Thrown when a chunk's size runs past its parent.
+auto create_verify_manifest(Ucfb_reader root,
+                            const std::filesystem::path& output_directory,
+                            std::vector<Output_checksum> outputs) -> std::string;